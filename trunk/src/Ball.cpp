@@ -1,19 +1,17 @@
 #include "Ball.hpp"
 #include "Framework.hpp"
 #include <cmath>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 
-Ball::Ball(Framework* control)
-: framework(control), radius(0.2), quad(NULL), displist(-1), spawntimer(-1), acceltimer(-1), scale(0.0),
-  position(0.0, 0.0, 0.0), speed(0.0, 0.0, 0.0), zSpeed(0.0)
-{
-}
+GLUquadricObj* Ball::quad = NULL;
+int Ball::displist = -1;
 
-Ball::~Ball()
+Ball::Ball(Framework* control)
+: framework(control), radius(0.2), spawnstart(0), spawnlength(0), growing(false), acceltimer(-1),
+  position(0.0, 0.0, 0.0), previous(0.0, 0.0, 0.0), speed(0.0, 0.0, 0.0), zSpeed(0.0), untilEvent(0.0)
 {
-	if (quad != NULL) gluDeleteQuadric(quad);
-	if (displist != -1) glDeleteLists(displist, 1);
 }
 
 void Ball::setPosition(const Vec3f& pos)
@@ -21,6 +19,15 @@ void Ball::setPosition(const Vec3f& pos)
 	position.x = pos.x;
 	position.y = pos.y;
 	position.z = pos.z;
+	previous = position;
+	untilEvent = 0.0;
+}
+
+void Ball::follow(const Vec3f& pos)
+{
+	previous = position;
+	position = pos;
+	untilEvent = 0.0;
 }
 
 void Ball::setSpeed(const Vec3f& spd)
@@ -28,6 +35,7 @@ void Ball::setSpeed(const Vec3f& spd)
 	speed.x = spd.x;
 	speed.y = spd.y;
 	speed.z = spd.z;
+	untilEvent = 0.0;
 
 	/* we have a new speed we want to achieve
 		actually, it is yet achieved. but after bounces, it could get lower
@@ -37,68 +45,57 @@ void Ball::setSpeed(const Vec3f& spd)
 
 void Ball::action(Event event)
 {
-	if (event == GROW)
-	{
-		scale = double(spawndone) / (double)(spawndone + spawntodo);
-		if (spawntodo == 0)
-		{
-			framework->removeTimer(spawntimer);
-			spawntimer = -1;
-		} else {
-			spawndone++;
-			spawntodo--;
-		}
-	} else if (event == SHRINK)
-	{
-		scale = double(spawntodo) / (double)(spawndone + spawntodo);
-		if (spawntodo == 0)
-		{
-			framework->removeTimer(spawntimer);
-			spawntimer = -1;
-		} else {
-			spawndone++;
-			spawntodo--;
-		}
-	} else if (event == ACCELERATE)
+	if (event == ACCELERATE)
 	{
 	}
 }
 
 void Ball::move(int ticks)
 {
-	Vec3f destination;
-
-	// determine the minimum desired stepping
-	double time = 1000.0 * 0.05f / std::max(fabs(speed.x), std::max(fabs(speed.y), fabs(speed.z)));
+	// time left to fly in seconds
+	Scalar time = Scalar(ticks) / 1000.0;
+	Collision collide;
+	previous = position;
+
+	// nothing can happen before the next event, so there is nothing to ask for
+	if (time < untilEvent) {
+		position.x += speed.x * time;
+		position.y += speed.y * time;
+		position.z += speed.z * time;
+		untilEvent -= time;
+		return;
+	}
 
-	// perhaps our system is fast enough to provide more than our minimum desired stepping
-	if (ticks < time) time = ticks;
-	for (int steps = 0; steps < ticks / (int)round(time); steps++)
+	/* fly from impact to impact. a frame seldom sees more than one, but in a corner
+	   we bounce off two walls and then perhaps a paddle */
+	for (int bounces = 0; (time > 0.0) && (bounces < 4); bounces++)
 	{
-		destination.x = position.x + speed.x * time / 1000.0;
-		destination.y = position.y + speed.y * time / 1000.0;
-		destination.z = position.z + speed.z * time / 1000.0;
-
-		Collision* collide = framework->detectCol(destination, speed, radius);
-
-		if (collide == NULL) {
-			position.x = destination.x;
-			position.y = destination.y;
-			position.z = destination.z;
-		} else {
-			position.x = collide->position.x;
-			position.y = collide->position.y;
-			position.z = collide->position.z;
-			speed.x = collide->speed.x;
-			speed.y = collide->speed.y;
-			speed.z = collide->speed.z;
-
-			delete collide;
+		Scalar impact = time;
+		if (!framework->detectCol(position, speed, radius, impact, collide)) {
+			position.x += speed.x * time;
+			position.y += speed.y * time;
+			position.z += speed.z * time;
+			break;
 		}
+
+		position = collide.position;
+		speed = collide.speed;
+		time -= impact;
 	}
+	untilEvent = framework->nextEvent(position, speed, radius);
+}
+
+void Ball::takeSnapshot(BallSnapshot& shot)
+{
+	shot.previous = previous;
+	shot.position = position;
+	shot.radius = radius;
+	shot.spawnstart = spawnstart;
+	shot.spawnlength = spawnlength;
+	shot.growing = growing;
 }
 
-void Ball::draw()
+void Ball::draw(const BallSnapshot& shot, double alpha, double time)
 {
 	if (displist == -1)
 	{
@@ -121,15 +118,22 @@ void Ball::draw()
 			gluQuadricNormals(quad, GLU_SMOOTH);
 			//gluQuadricTexture(quad, GL_TRUE);
 		}
-		gluSphere(quad, radius, 32, 32);
+		gluSphere(quad, toDouble(shot.radius), 32, 32);
 
 		glEndList();
 	}
 
 	glPushMatrix();
-	/* Move to position */
-	glTranslatef(position.x, position.y, position.z);
-	/* shrink/grow */
+	/* Move to position, as far as the ball got since the last move */
+	const Vec3f& previous = shot.previous;
+	const Vec3f& position = shot.position;
+	glTranslatef(toDouble(previous.x) + toDouble(position.x - previous.x) * alpha,
+		toDouble(previous.y) + toDouble(position.y - previous.y) * alpha,
+		toDouble(previous.z) + toDouble(position.z - previous.z) * alpha);
+	/* shrink/grow, as far as it got at the time drawn */
+	double done = (time - shot.spawnstart) / std::max(shot.spawnlength, 1u);
+	done = std::min(std::max(done, 0.0), 1.0);
+	double scale = (shot.growing ? done : 1.0 - done);
 	glScalef(scale, scale, scale);
 
 	glCallList(displist);
@@ -138,19 +142,14 @@ void Ball::draw()
 
 void Ball::shrink(int ticks)
 {
-	spawntodo = (int)round(ticks / 25);
-	spawndone = 0;
-	if (spawntimer != -1) { framework->removeTimer(spawntimer);
-	}
-		spawntimer = framework->addTimer(25, SHRINK, this);
+	spawnstart = framework->getTime();
+	spawnlength = std::max(ticks, 0);
+	growing = false;
 }
 
 void Ball::grow(int ticks)
 {
-
-	spawntodo = (int)round(ticks / 25);
-	spawndone = 0;
-	if (spawntimer != -1) {framework->removeTimer(spawntimer);
-	}
-		spawntimer = framework->addTimer(25, GROW, this);
+	spawnstart = framework->getTime();
+	spawnlength = std::max(ticks, 0);
+	growing = true;
 }
@@ -4,6 +4,7 @@
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include "stuff.hpp"
+#include "Snapshot.hpp"
 
 class Framework;
 
@@ -15,21 +16,24 @@ public:
 	/*!	\param control the game's Framework (ie Server or Client) object
 	*/
 	Ball(Framework *control);
-	//! The destructor
-	~Ball();
 
 	//! returns the radius
-	inline double getRadius() { return radius; }
+	inline Scalar getRadius() { return radius; }
 	//! returns a reference to the position
 	inline const Vec3f& getPosition() { return position; }
 	//! returns a reference to the speed vector
 	inline const Vec3f& getSpeed() { return speed; }
 
 	//! set a new position
-	/*! used by the Client
+	/*! used by the Client; the ball jumps there, it isn't drawn on the way
 		\param pos reference to the new position
 	*/
 	void setPosition(const Vec3f& pos);
+	//! move to a new position, as if the ball flew there
+	/*! used by the Client, see BallTrack; the ball is drawn on the way from where it was
+		\param pos reference to the new position
+	*/
+	void follow(const Vec3f& pos);
 	//! set new speed values
 	/*! \param spd reference to the new speed vector
 	*/
@@ -40,22 +44,38 @@ public:
 	*/
 	void action(Event event);
 
+	//! returns how long the ball flies straight on before it could hit something (seconds)
+	inline Scalar getNextEvent() { return untilEvent; }
+
 	//! move on
-	/*! Let's the ball move for some time. It will ask for collisions itself.
+	/*! Let's the ball move for some time. Until the next event predicted by Framework::nextEvent(),
+	    it just flies on without asking anyone; only then it asks for collisions, once plus once
+	    per bounce, and predicts the next event.
+	    The position before is kept for drawing in between.
 		\param ticks the time evolved in ms
 	*/
 	void move(int ticks);
-	//! draw the ball using GL functions
-	void draw();
+
+	//! note what is to be drawn of the ball
+	/*!	\param shot the snapshot to fill
+	*/
+	void takeSnapshot(BallSnapshot& shot);
+	//! draw a ball using GL functions, called by the render thread
+	/*! All balls share one display list, the render thread's only.
+		\param shot the ball as noted by takeSnapshot()
+		\param alpha where to draw between the position before the last move() (0) and the actual one (1)
+		\param time the simulation time drawn (ticks), for shrinking and growing
+	*/
+	static void draw(const BallSnapshot& shot, double alpha, double time);
 
 	//! shrink the ball
-	/*! start the process of shrinking
+	/*! start the process of shrinking; no timer needed, draw() finds out how far it got
 		\param ticks duration of the scaling process in ms
 	*/
 	void shrink(int ticks);
 
 	//! grow the ball
-	/*! start the process of growing
+	/*! start the process of growing; no timer needed, draw() finds out how far it got
 		\param ticks duration of the scaling process in ms
 	*/
 	void grow(int ticks);
@@ -64,23 +84,27 @@ private:
 	Framework *framework;
 
 	//! radius of the ball
-	double radius;
+	Scalar radius;
 	//! the actual position
 	Vec3f position;
+	//! the position before the last move()
+	Vec3f previous;
 	//! speed values for every axis
 	Vec3f speed;
 	//! minimum z speed the ball constantly accelerates to
-	double zSpeed;
+	Scalar zSpeed;
+	//! time left until the next event, 0 to ask again
+	Scalar untilEvent;
 	//! pointer to our quadrik which builds the sphere
-	GLUquadricObj *quad;
+	static GLUquadricObj *quad;
 	//! descriptor of the utilized display list
-	int displist;
-	//! actual scaling (shrink/grow)
-	double scale;
-	//! describing the scaling progress
-	int spawntodo, spawndone;
-	//! reference to the timer used for scaling
-	int spawntimer;
+	static int displist;
+	//! when the last shrink() or grow() started (simulation time, ticks)
+	unsigned int spawnstart;
+	//! how long the last shrink() or grow() takes (ticks)
+	unsigned int spawnlength;
+	//! wether the ball grows (or shrinks)
+	bool growing;
 	//! reference to the timer used for accelerating
 	int acceltimer;
 };
@@ -0,0 +1,122 @@
+#include "BallTrack.hpp"
+#include <algorithm>
+#include <cmath>
+
+//! units per tick (ms) no ball flies, moving faster means it jumped
+static const double JUMP = 0.04;
+//! how fast the offset may grow, if the link gets slower (ticks per tick)
+static const double DRIFT = 0.001;
+//! arriving this much later than expected, the Server must have stalled: start over (ticks)
+static const double RESTART = 1000.0;
+
+//! returns the position part of the way from one to another, or beyond if part > 1
+static Vec3f lerp(const Vec3f& from, const Vec3f& to, double part)
+{
+	return Vec3f(toDouble(from.x) + toDouble(to.x - from.x) * part,
+		toDouble(from.y) + toDouble(to.y - from.y) * part,
+		toDouble(from.z) + toDouble(to.z - from.z) * part);
+}
+
+BallTrack::BallTrack(unsigned int timestep)
+ : step(timestep), arrived(0), offset(0.0), delay(0.0)
+{
+	clear();
+}
+
+void BallTrack::clear()
+{
+	count = 0;
+	newest = 0;
+	jitter = 0.0;
+	shown = 0.0;
+	interval = step;
+}
+
+void BallTrack::add(unsigned int tick, const Vec3f& position, unsigned int arrival)
+{
+	double time = double(tick) * step;
+	double sample = double(arrival) - time;
+	if ((count > 0)&&(sample - offset - DRIFT * (arrival - arrived) > RESTART))
+		clear();
+
+	if (count == 0) {
+		offset = sample;
+		delay = offset + interval;
+	} else {
+		// the fastest arrival lately is the one with the least delay, the others are late by jitter
+		offset = std::min(sample, offset + DRIFT * (arrival - arrived));
+		double late = sample - offset;
+		// follows the latest one at once, but forgets it only slowly, as more are likely to follow
+		if (late > jitter)
+			jitter = late;
+		else	jitter += (late - jitter) / 64.0;
+		if (time > at(0).time)
+			interval += (time - at(0).time - interval) / 8.0;
+	}
+
+	// most likely it's the latest, but it may have overtaken a few
+	int back = 0;
+	while ((back < count)&&(at(back).time > time))
+		back++;
+	if ((back < count)&&(at(back).time == time)) return;
+	if (back == SIZE) return;
+
+	newest = (newest + 1) % SIZE;
+	count = std::min(count + 1, (int)SIZE);
+	for (int i = 0; i < back; i++)
+		at(i) = at(i + 1);
+	at(back).time = time;
+	at(back).position = position;
+	markCut(back);
+	if (back > 0) markCut(back - 1);
+	arrived = arrival;
+}
+
+void BallTrack::markCut(int back)
+{
+	Entry& to = at(back);
+	if (back + 1 == count) {
+		to.cut = false;
+		return;
+	}
+	const Entry& from = at(back + 1);
+	to.cut = fabs(toDouble(to.position.x - from.position.x)) + fabs(toDouble(to.position.y - from.position.y))
+		+ fabs(toDouble(to.position.z - from.position.z)) > JUMP * (to.time - from.time);
+}
+
+bool BallTrack::get(unsigned int now, Vec3f& position)
+{
+	if (count == 0) return false;
+
+	// the delay changes by a tenth of a step per step at most, so the ball never jumps for it
+	double wanted = offset + interval + jitter;
+	delay += std::max(-0.1 * step, std::min(0.1 * step, wanted - delay));
+	double time = double(now) - delay;
+	shown = std::max(0.0, time);
+
+	// later than the latest position: fly on, if we know how fast
+	const Entry& last = at(0);
+	if (time >= last.time) {
+		const Entry& before = at(1);
+		if ((count > 1)&&(!last.cut)&&(last.time > before.time))
+			position = lerp(before.position, last.position,
+				1.0 + std::min(time - last.time, double(EXTRAPOLATION)) / (last.time - before.time));
+		else	position = last.position;
+		return true;
+	}
+
+	// otherwise between two of them, or before the oldest one
+	for (int i = 1; i < count; i++)
+	{
+		const Entry& after = at(i - 1);
+		const Entry& before = at(i);
+		if (time < before.time) continue;
+
+		if (after.cut)
+			position = before.position;
+		else	position = lerp(before.position, after.position, (time - before.time) / (after.time - before.time));
+		return true;
+	}
+	position = at(count - 1).position;
+	return true;
+}
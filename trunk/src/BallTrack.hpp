@@ -0,0 +1,94 @@
+#ifndef BALLTRACK_H
+#define BALLTRACK_H
+
+#include "stuff.hpp"
+
+//! The positions of the ball the Client got from the Server lately, to show it smoothly
+/*! The WorldStates arrive at the Server's send rate, some late and some not at all. Instead of
+    jumping to every one of them, the Client shows the ball a little in the past, where it knows
+    the positions before and after, and moves it between them. The delay follows the link: the time
+    between two states plus how much later than the fastest one they arrive lately. If the states
+    stay away for longer than that, the ball flies on with the speed it had between the latest two,
+    for EXTRAPOLATION ticks at most.
+    The Server's time is its tick times the step; the Client's is its own, the difference between
+    them is worked out from the arrivals.
+*/
+class BallTrack
+{
+public:
+	enum {
+		//! how many positions are kept
+		SIZE = 32,
+		//! how long the ball flies on without news at most (ticks)
+		EXTRAPOLATION = 250
+	};
+
+	//! The constructor
+	/*!	\param step the Server's step (ticks), see Framework::getTimestep()
+	*/
+	BallTrack(unsigned int step);
+
+	//! forget every position, as the Server's time stood still (paused)
+	void clear();
+
+	//! add a position
+	/*! They may arrive out of order, then it's put where it belongs. If there is one for the tick
+	    already, it's dropped. One older than every one kept becomes the oldest, unless the track
+	    is full already, then it's dropped as well.
+		\param tick the Server's step the position was taken at
+		\param position the ball's position
+		\param arrival the actual time (ticks)
+	*/
+	void add(unsigned int tick, const Vec3f& position, unsigned int arrival);
+
+	//! returns where the ball is to be shown, called once per step
+	/*!	\param now the actual time (ticks)
+		\param position filled with the position
+		\result false if there is no position yet
+	*/
+	bool get(unsigned int now, Vec3f& position);
+
+	//! returns the Server's time the ball was shown at by the latest get() (ticks), 0 for none
+	inline double getShown() { return shown; }
+private:
+	//! a position the Server sent
+	struct Entry {
+		//! the Server's time it was taken at (ticks)
+		double time;
+		//! the position
+		Vec3f position;
+		//! wether the ball jumped there (served, or put back into the field), so it isn't moved there
+		bool cut;
+	};
+
+	//! returns a position, counting back from the latest one
+	inline Entry& at(int back) { return entry[(newest + SIZE - back) % SIZE]; }
+	//! work out wether the ball jumped to a position from the one before
+	/*!	\param back the position, counting back from the latest one
+	*/
+	void markCut(int back);
+
+	//! the Server's step (ticks)
+	unsigned int step;
+	//! the positions in the order of their time, the latest one at newest
+	Entry entry[SIZE];
+	//! how many positions are kept
+	int count;
+	//! the index of the latest position
+	int newest;
+	//! when the latest position arrived (ticks)
+	unsigned int arrived;
+	//! our time minus the Server's for the fastest arrival lately (ticks, with fractions)
+	double offset;
+	//! how much later than the fastest one the positions arrive lately (ticks)
+	double jitter;
+	//! the time between two positions, on average (ticks)
+	double interval;
+	//! our time minus the Server's time the ball is shown at (ticks, with fractions)
+	/*! That's the offset plus how far in the past the ball is shown; it follows them slowly. */
+	double delay;
+	//! the Server's time the ball was shown at lately (ticks)
+	double shown;
+};
+
+#endif
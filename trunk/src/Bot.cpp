@@ -0,0 +1,54 @@
+#include "Bot.hpp"
+#include "Player.hpp"
+#include "Ball.hpp"
+#include "Field.hpp"
+
+Bot::Bot(Player* paddle, double err, unsigned int s)
+ : player(paddle), error(err), seed(s), known(0.0, 0.0, 0.0), target(0.0, 0.0), predictions(0)
+{
+}
+
+Scalar Bot::fold(Scalar v, Scalar limit)
+{
+	// the ball goes from -limit to limit and back, over and over
+	Scalar period = limit * 4.0;
+	Scalar u = v + limit;
+	u -= floor(u / period) * period;
+	if (u > limit * 2.0) u = period - u;
+	return u - limit;
+}
+
+Vec2f Bot::predict(const Vec3f& position, const Vec3f& speed, Scalar radius, Field& field, Scalar z)
+{
+	Scalar time = (z - position.z) / speed.z;
+	return Vec2f(fold(position.x + speed.x * time, field.getWidth()/2.0 - radius),
+		fold(position.y + speed.y * time, field.getHeight()/2.0 - radius));
+}
+
+double Bot::random()
+{
+	seed = seed * 1103515245u + 12345u;
+	return ((seed >> 16) & 0x7fff) / 16383.5 - 1.0;
+}
+
+void Bot::update(Ball& ball, Field& field, unsigned int time)
+{
+	const Vec3f& speed = ball.getSpeed();
+	if ((speed.x != known.x)||(speed.y != known.y)||(speed.z != known.z))
+	{
+		// it bounced (or got served), so it's going somewhere else
+		known = speed;
+		Scalar zSign = (player->getSide() == FRONT ? 1.0 : -1.0);
+		if (speed.z * zSign > 0.0) {
+			target = predict(ball.getPosition(), speed, ball.getRadius(), field,
+				(player->getFront() - ball.getRadius()) * zSign);
+			target.x += error * random();
+			target.y += error * random();
+		} else	target = Vec2f(0.0, 0.0); // it flies away, so we wait in the middle
+		predictions++;
+	}
+
+	Vec2f pos = player->getPosition();
+	if ((target.x != pos.x)||(target.y != pos.y))
+		player->move(toDouble(target.x - pos.x), toDouble(target.y - pos.y), time);
+}
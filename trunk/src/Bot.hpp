@@ -0,0 +1,72 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "stuff.hpp"
+
+class Player;
+class Ball;
+class Field;
+
+//! Mr. Wand, moving a paddle all by himself
+/*! He foresees where the ball reaches his paddle. On its way there, the ball only bounces off the walls,
+    which is the same as flying straight on through a row of mirrored fields; so the straight landing
+    point folded back into the field is where it arrives. This is calculated once whenever the ball changes
+    its speed (so once per bounce), every step the paddle just moves on towards it.
+*/
+class Bot
+{
+public:
+	//! The constructor
+	/*!	\param paddle the player whose paddle is moved
+		\param error how far he misses the landing point at most on each axis, 0 for never (units)
+		\param seed the start of the random numbers used for missing
+	*/
+	Bot(Player* paddle, double error = 0.0, unsigned int seed = 1);
+
+	//! move the paddle towards where the ball is going to arrive, called every simulation step
+	/*!	\param ball the ball to catch
+		\param field the field the ball bounces in
+		\param time the actual simulation time in ticks (ms)
+	*/
+	void update(Ball& ball, Field& field, unsigned int time);
+
+	//! predict where a ball bouncing off the field's walls crosses a Z plane
+	/*!	\param position where the ball is
+		\param speed the speed of the ball flying (units per second), heading to the plane
+		\param radius the ball's radius
+		\param field the field the ball bounces in
+		\param z the plane the ball's center crosses
+		\result the X and Y coordinate of the ball's center there
+	*/
+	static Vec2f predict(const Vec3f& position, const Vec3f& speed, Scalar radius, Field& field, Scalar z);
+
+	//! returns the player whose paddle is moved
+	inline Player* getPlayer() { return player; }
+	//! returns how often the landing point was calculated
+	inline unsigned long getPredictions() { return predictions; }
+private:
+	//! fold a coordinate reached by flying straight back between two walls
+	/*!	\param v the coordinate
+		\param limit how far the ball's center gets from the middle, the walls are at +-limit
+		\result the coordinate inside
+	*/
+	static Scalar fold(Scalar v, Scalar limit);
+
+	//! returns a random number from -1 to 1, the same sequence on every machine
+	double random();
+
+	//! the player whose paddle is moved
+	Player* player;
+	//! how far the target is off at most
+	double error;
+	//! state of the random numbers
+	unsigned int seed;
+	//! the ball's speed the target was calculated for
+	Vec3f known;
+	//! where the paddle is going to
+	Vec2f target;
+	//! how often the landing point was calculated
+	unsigned long predictions;
+};
+
+#endif
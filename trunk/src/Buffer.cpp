@@ -1,99 +1,136 @@
 #include "Buffer.hpp"
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 
-Buffer::Buffer() : size(sizeof(PacketType)), freemem(true)
+//! fails to compile if a packet's layout doesn't fit into an outgoing Buffer
+typedef char layouts_fit[(Buffer::CAPACITY >= WORLD_SIZE
+	&& Buffer::CAPACITY >= PADDLEMOVE_SIZE && Buffer::CAPACITY >= SCORE_SIZE
+	&& Buffer::CAPACITY >= ROUND_SIZE && Buffer::CAPACITY >= SERVE_BALL_SIZE
+	&& Buffer::CAPACITY >= WORLD_ACK_SIZE) ? 1 : -1];
+
+//! how many steps of pushFixed() make a unit
+static const double FIXED_ONE = 4096.0;
+
+Buffer::Buffer() : data(storage), size(0), pos(0)
 {
-	data = (char*)malloc(size);
 }
 
-Buffer::Buffer(PacketType t) : size(sizeof(PacketType)), freemem(true)
+Buffer::Buffer(PacketType t) : data(storage), size(0), pos(0)
 {
-	data = (char*)malloc(size);
 	setType(t);
 }
 
-Buffer::Buffer(char* content, int bytes) : data(content), size(bytes), pos(sizeof(PacketType)), freemem(false)
+Buffer::Buffer(char* content, int bytes) : data(content), size(bytes), pos(0)
 {
-	memcpy(&type, data, sizeof(PacketType));
+	type = (PacketType)popVarint();
 }
 
-Buffer::~Buffer()
+void Buffer::setType(PacketType t)
 {
-	if (freemem) free(data);
+	type = t;
+	size = 0;
+	pushVarint(t);
 }
 
-void Buffer::setType(PacketType t)
+void Buffer::pushVarint(unsigned int value)
 {
-	type = t;
-	memcpy(data, &type, sizeof(PacketType));
+	int bytes = 1;
+	for (unsigned int rest = value; rest >= 0x80; rest >>= 7)
+		bytes++;
+	if (size + bytes > CAPACITY) return;
+
+	while (value >= 0x80)
+	{
+		data[size++] = (char)(value | 0x80);
+		value >>= 7;
+	}
+	data[size++] = (char)value;
+}
+
+unsigned int Buffer::popVarint()
+{
+	unsigned int value = 0;
+	for (int shift = 0; (pos < size)&&(shift < 35); shift += 7)
+	{
+		unsigned char byte = data[pos++];
+		value |= (unsigned int)(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) return value;
+	}
+	// cut off
+	return 0;
 }
 
 void Buffer::pushInt(int value)
 {
-	data = (char*)realloc(data, size + sizeof(int));
-	memcpy(data + size, &value, sizeof(int));
-	size += sizeof(int);
+	// zigzag: 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...
+	pushVarint(((unsigned int)value << 1) ^ (unsigned int)(value >> 31));
+}
+
+short Buffer::quantize(double value)
+{
+	double steps = floor(value * FIXED_ONE + 0.5);
+	return (short)std::max(-32768.0, std::min(32767.0, steps));
+}
+
+double Buffer::dequantize(short fixed)
+{
+	return fixed / FIXED_ONE;
 }
 
-void Buffer::pushDouble(double value)
+void Buffer::pushFixed(double value)
 {
-	data = (char*)realloc(data, size + sizeof(double));
-	memcpy(data + size, &value, sizeof(double));
-	size += sizeof(double);
+	if (size + FIXED_SIZE > CAPACITY) return;
+	short fixed = quantize(value);
+	data[size++] = (char)(fixed & 0xff);
+	data[size++] = (char)((fixed >> 8) & 0xff);
 }
 
 void Buffer::pushId(grapple_user value)
 {
-	data = (char*)realloc(data, size + sizeof(grapple_user));
-	memcpy(data + size, &value, sizeof(grapple_user));
-	size += sizeof(Side);
+	pushVarint(value);
 }
 
 void Buffer::pushSide(Side value)
 {
-	data = (char*)realloc(data, size + sizeof(Side));
-	memcpy(data + size, &value, sizeof(Side));
-	size += sizeof(Side);
+	pushVarint(value);
 }
 
 void Buffer::pushString(const std::string& str)
 {
-	data = (char*)realloc(data, size + str.size() + 1);
-	memcpy(data + size, str.c_str(), str.size() + 1);
-	size += str.size() + 1;
+	int bytes = std::min((int)str.size(), CAPACITY - size - 1);
+	if (bytes < 0) return;
+	memcpy(data + size, str.c_str(), bytes);
+	size += bytes;
+	data[size++] = 0;
 }
 
 int Buffer::popInt()
 {
-	int value;
-	memcpy(&value, data + pos, sizeof(int));
-	pos += sizeof(int);
-	return value;
+	unsigned int zigzag = popVarint();
+	return (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
 }
 
-double Buffer::popDouble()
+double Buffer::popFixed()
 {
-	double value;
-	memcpy(&value, data + pos, sizeof(double));
-	pos += sizeof(double);
-	return value;
+	if (pos + FIXED_SIZE > size) {
+		pos = size;
+		return 0.0;
+	}
+	short fixed = (short)((unsigned char)data[pos] | ((unsigned char)data[pos + 1] << 8));
+	pos += FIXED_SIZE;
+	return dequantize(fixed);
 }
 
 grapple_user Buffer::popId()
 {
-	grapple_user value;
-	memcpy(&value, data + pos, sizeof(grapple_user));
-	pos += sizeof(grapple_user);
-	return value;
+	return (grapple_user)popVarint();
 }
 
 Side Buffer::popSide()
 {
-	Side value;
-	memcpy(&value, data + pos, sizeof(Side));
-	pos += sizeof(Side);
-	return value;
+	return (Side)popVarint();
 }
 
 std::string Buffer::popString()
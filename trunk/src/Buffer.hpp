@@ -15,10 +15,8 @@ enum PacketType {
 	PAUSE_REQUEST,
 	//! requesting non-paused state
 	RESUME_REQUEST,
-	//! server telling the ball's position
-	BALLPOSITION,
-	//! server telling a paddle's position
-	PADDLEPOSITION,
+	//! server telling the state of the world, see WorldState
+	WORLD,
 	//! client requesting paddle movement
 	PADDLEMOVE,
 	//! server reporting a score
@@ -26,13 +24,62 @@ enum PacketType {
 	//! server telling the actual round
 	ROUND,
 	//! demanding and reporting the ball to be served
-	SERVE_BALL
+	SERVE_BALL,
+	//! client telling the latest WORLD it got
+	WORLD_ACK
+};
+
+//! the size of every packet's layout in bytes at most, its type included
+/*! An outgoing Buffer has room for the biggest one, see Buffer::CAPACITY. */
+enum PacketSize {
+	//! a PacketType, a varint taking a single byte as long as there are less than 128 types
+	TYPE_SIZE = 1,
+	//! the most bytes a varint takes, see Buffer::pushInt()
+	VARINT_SIZE = 5,
+	//! a quantized coordinate, see Buffer::pushFixed()
+	FIXED_SIZE = 2,
+
+	//! READY, UNREADY, PAUSE_REQUEST and RESUME_REQUEST carry nothing but their type
+	SIMPLE_SIZE = TYPE_SIZE,
+	//! a WorldState of 4 paddles: tick, base, ids in a keyframe, changed bits, up to 3 bytes per change,
+	//! then the sequence number of the client's latest movement applied
+	WORLD_SIZE = TYPE_SIZE + 3 * VARINT_SIZE + 4 * VARINT_SIZE + VARINT_SIZE + (3 + 2 * 4) * 3 + VARINT_SIZE,
+	//! the sequence number, the step the client shows the ball at, the time, the movement's y and x
+	PADDLEMOVE_SIZE = TYPE_SIZE + 3 * VARINT_SIZE + 2 * FIXED_SIZE,
+	//! the side which scored and its points
+	SCORE_SIZE = TYPE_SIZE + 2 * VARINT_SIZE,
+	//! the round
+	ROUND_SIZE = TYPE_SIZE + VARINT_SIZE,
+	//! the id of the player to serve
+	SERVE_BALL_SIZE = TYPE_SIZE + VARINT_SIZE,
+	//! the tick of the WORLD, the step the client shows the ball at
+	WORLD_ACK_SIZE = TYPE_SIZE + 2 * VARINT_SIZE
 };
 
 //! Used to manage any incoming packet or create an outgoing packet
+/*! An outgoing packet is built in storage inside the Buffer, which is sized at compile time to
+    hold the biggest PacketSize, so building and sending a packet never touches the heap.
+    An incoming packet is read right from where the network left it.
+    The encoding is compact and the same on every machine: the type, integers, ids and sides are
+    varints, and coordinates are quantized to 16 bit fixed point, always in little endian.
+    Reading past the end of a packet gives 0 instead of what lies behind it.
+*/
 class Buffer
 {
 public:
+	//! the most bytes an outgoing packet can hold
+	static const int CAPACITY = 80;
+
+	//! quantize a value to 16 bit fixed point, as sent by pushFixed()
+	/*!	\param value the value, from -8 to 8; values beyond are clamped
+		\result the value in steps of 1/4096
+	*/
+	static short quantize(double value);
+	//! returns a quantized value as a double again
+	/*!	\param fixed the value in steps of 1/4096
+	*/
+	static double dequantize(short fixed);
+
 	//! default constructor for an outgoing packet
 	Buffer();
 	//! constructor with type for an outgoing packet
@@ -44,35 +91,46 @@ public:
 		\param bytes the data's size
 	*/
 	Buffer(char* content, int bytes);
-	//! destructor cleaning up if the Buffer holds it's own memory field
-	~Buffer();
 
 	//! set the packet's type
-	/*! \param t the type of the packet we want to send */
+	/*! It goes first, so this starts the packet over.
+		\param t the type of the packet we want to send */
 	void setType(PacketType t);
 	//! add an integer value to the packet
-	/*! \param value the value itself */
+	/*! Zigzag coded into a varint: 7 bits per byte, so small values of either sign take a single byte.
+		\param value the value itself */
 	void pushInt(int value);
-	//! add a double value to the packet
+	//! add a coordinate (or any value from -8 to 8) to the packet
+	/*! It's quantized to 16 bits with 12 of them for the fraction, which is finer than 1/4000 of a
+	    unit on a field 4 units wide, high and 8 long. Values beyond are clamped.
+		\param value the value itself */
+	void pushFixed(double value);
+	//! add an unsigned value to the packet, as a varint
+	/*! 7 bits per byte from the lowest ones on, the highest bit telling if there are more.
+		\param value the value itself */
+	void pushVarint(unsigned int value);
+	//! add a player id to the packet, as a varint
 	/*! \param value the value itself */
-	void pushDouble(double value);
-
 	void pushId(grapple_user value);
 	//! add a Side value to the packet
 	/*! \param value the value itself */
 	void pushSide(Side value);
 	//! add a variable sized string to the packet
-	/*! This is only possible at the end of a packet.
+	/*! This is only possible at the end of a packet. It's cut off where the packet is full.
 	\param str the string */
 	void pushString(const std::string& str);
 
 	//! collect an integer value from the packet
 	/*! \result the value itself */
 	int popInt();
-	//! collect a double value from the packet
+	//! collect a coordinate from the packet
+	/*! \result the value itself, as quantized by pushFixed() */
+	double popFixed();
+	//! collect a varint from the packet
+	/*! \result the value itself, 0 if the packet ends before it */
+	unsigned int popVarint();
+	//! collect a player id from the packet
 	/*! \result the value itself */
-	double popDouble();
-
 	grapple_user popId();
 
 	//! collect a Side value from the packet
@@ -91,9 +149,15 @@ public:
 	//! return the data size, used for outgoing packages
 	inline int getSize() { return size; }
 private:
-	//! wether we need to free the memory or it was allocated outside
-	bool freemem;
-	//! pointer to the data
+	//! a Buffer can't be copied, data may point into it
+	Buffer(const Buffer&);
+	//! a Buffer can't be assigned, data may point into it
+	Buffer& operator=(const Buffer&);
+
+
+	//! the outgoing packet
+	char storage[CAPACITY];
+	//! pointer to the data, either storage or the incoming packet
 	char* data;
 	//! the data field size
 	int size;
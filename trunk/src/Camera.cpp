@@ -35,16 +35,16 @@ void Camera::translate()
 {
 	glLoadIdentity();
 	glTranslatef(0.0, 0.0, -distance);
-	glRotatef(angle.y, 1.0, 0.0, 0.0);
-	glRotatef(angle.x, 0.0, 1.0, 0.0);
+	glRotatef(toDouble(angle.y), 1.0, 0.0, 0.0);
+	glRotatef(toDouble(angle.x), 0.0, 1.0, 0.0);
 }
 
 void Camera::adjustAngle(double x, double y)
 {
 	angle.x += x;
 	angle.y += y;
-	angle.x = std::min(fabs(angle.x), 10.0) * (angle.x > 0 ? 1.0 : -1.0);
-	angle.y = std::min(fabs(angle.y), 10.0) * (angle.y > 0 ? 1.0 : -1.0);
+	angle.x = std::min(fabs(angle.x), Scalar(10.0)) * (angle.x > 0.0 ? 1.0 : -1.0);
+	angle.y = std::min(fabs(angle.y), Scalar(10.0)) * (angle.y > 0.0 ? 1.0 : -1.0);
 }
 
 void Camera::adjustDistance(double dist)
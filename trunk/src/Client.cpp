@@ -1,10 +1,14 @@
 #include "Client.hpp"
+#include "RateControl.hpp"
 #include <iostream>
 #include <sstream>
 
 Client::Client(void *surf, const Configuration& conf)
- : Framework(surf, conf, CONNECTING), playername(conf.playername)
+ : Framework(surf, conf, CONNECTING), playername(conf.playername), newest(0), track(getTimestep()), moveseq(0), roundtrip(0.0)
 {
+	for (int i = 0; i < MOVES; i++)
+		moves[i].seq = 0;
+
 	client = initNetwork(conf.version, conf.servername, conf.port, conf.playername);
 	if (client == -1)
 		shutdown();
@@ -41,16 +45,59 @@ void Client::movePaddle(double x, double y, unsigned int time)
 {
 	if (state == RUNNING)
 	{
+		// move just like the server will, instead of waiting a round trip for it
+		Move& move = moves[++moveseq % MOVES];
+		move.seq = moveseq;
+		move.x = Buffer::dequantize(Buffer::quantize(x));
+		move.y = Buffer::dequantize(Buffer::quantize(y));
+		move.time = time;
+		peer[localid].player->move(move.x, move.y, time);
+
+		// the server rewinds our paddle to what we saw, if the ball got past it
 		Buffer sbuf(PADDLEMOVE);
+		sbuf.pushVarint(moveseq);
+		sbuf.pushVarint((unsigned int)(track.getShown() / getTimestep()));
 		sbuf.pushInt(time);
-		sbuf.pushDouble(y);
-		sbuf.pushDouble(-x);
+		sbuf.pushFixed(move.y);
+		sbuf.pushFixed(-move.x);
 		sendPacket(sbuf, false);
 	}
 }
 
-// nothing to do here on the client side
-void Client::updateGame(int ticks) {}
+void Client::reconcile(double x, double y, unsigned int applied)
+{
+	Player* own = peer[localid].player;
+	const Move& last = moves[applied % MOVES];
+	if ((applied == 0)||(last.seq != applied)||(moveseq - applied >= MOVES)) {
+		// nothing to start from; as long as none of our movements is on its way, the server knows best
+		if ((moveseq == 0)||(isLost(moves[moveseq % MOVES]))) own->setPosition(x, y);
+		return;
+	}
+
+	own->setPosition(x, y, last.time);
+	for (unsigned int seq = applied + 1; seq != moveseq + 1; seq++)
+		if ((moves[seq % MOVES].seq == seq)&&(!isLost(moves[seq % MOVES])))
+			own->move(moves[seq % MOVES].x, moves[seq % MOVES].y, moves[seq % MOVES].time);
+}
+
+bool Client::isLost(const Move& move)
+{
+	// it reaches the server after half a round trip, the next WorldState tells us at most a period
+	// later, and takes another half back
+	return (roundtrip != 0.0)&&((int)(getTime() - move.time) > roundtrip + RateControl::MAXPERIOD);
+}
+
+void Client::updateGame(int ticks)
+{
+	// the server's time stands still while paused, so the track would run ahead of it
+	if (paused != 0) {
+		track.clear();
+		return;
+	}
+	Vec3f pos;
+	if ((!ball.empty())&&(track.get(getTime(), pos)))
+		ball[0].follow(pos);
+}
 
 void Client::serveBall()
 {
@@ -103,7 +150,6 @@ void Client::doNetworking()
 						Side side = (i->first == localid ? FRONT : BACK);
 						i->second.player = new Player(this, i->second.name, side, field.getLength()/2.0f);
 						player.push_back(i->second.player);
-						i->second.player->run();
 					}
 					output.updateScore(FRONT, 0);
 					output.updateScore(BACK, 0);
@@ -130,21 +176,37 @@ void Client::doNetworking()
 						ball[0].shrink(1000);
 					}
 				break;
-				case BALLPOSITION:
-					{	// in the future, we have to check for the player's side
-						double a = -buf.popDouble();
-						double b =  buf.popDouble();
-						double c = -buf.popDouble();
-						ball[0].setPosition(Vec3f(a, b, c));
-					}
-				break;
-				case PADDLEPOSITION:
+				case WORLD:
 					{
-						grapple_user id = buf.popId();
-						if (peer[id].player != NULL)
-							peer[id].player->setPosition(-buf.popDouble(), buf.popDouble());
-						else
-							std::cerr << "Fatal: Wanted to access uninitialized player " << peer[id].name << std::endl;
+						WorldState world;
+						// without its base we can't decode it, the server sends a keyframe soon
+						if (!received.read(buf, world)) break;
+						received.store(world);
+						// which of our movements are in the paddle's position
+						unsigned int applied = buf.popVarint();
+
+						// the step we show the ball at goes along, so the server knows where our paddle
+						// was then, even if it didn't move
+						Buffer sbuf(WORLD_ACK);
+						sbuf.pushVarint(world.tick);
+						sbuf.pushVarint((unsigned int)(track.getShown() / getTimestep()));
+						sendPacket(sbuf, false);
+
+						// in the future, we have to check for the player's side
+						// the track takes late ones too, they fill a gap
+						Vec3f pos = world.getBall();
+						track.add(world.tick, Vec3f(-pos.x, pos.y, -pos.z), getTime());
+
+						if ((int)(world.tick - newest) <= 0) break;
+						newest = world.tick;
+
+						for (int i = 0; i < world.paddles; i++)
+							if (peer[world.id[i]].player != NULL) {
+								Vec2f paddle = world.getPaddle(i);
+								if (world.id[i] == localid)
+									reconcile(-toDouble(paddle.x), toDouble(paddle.y), applied);
+								else	peer[world.id[i]].player->setPosition(-toDouble(paddle.x), toDouble(paddle.y));
+							}
 					}
 				break;
 				case SERVE_BALL:
@@ -178,7 +240,11 @@ void Client::doNetworking()
 			shutdown();
 			break;
 		case GRAPPLE_MSG_PING:
-			if (message->PING.id == localid) output.updatePing(message->PING.pingtime);
+			if (message->PING.id == localid) {
+				output.updatePing(message->PING.pingtime);
+				// grapple measures in microseconds
+				roundtrip = message->PING.pingtime / 1000.0;
+			}
 			break;
 		}
 		grapple_message_dispose(message);
@@ -2,6 +2,8 @@
 #define CLIENT_H
 
 #include "Framework.hpp"
+#include "WorldState.hpp"
+#include "BallTrack.hpp"
 
 //! network game client
 /*! The client can't do anything by its own. It's intended to give away all the work to the Server
@@ -26,13 +28,28 @@ public:
 
 private:
 	//! process the player's desire to move on
-	/*! Tells the server that the player wants to move
+	/*! Moves the paddle right away and tells the server about it, at most once per step.
+	    The movement is kept with a sequence number until the server has applied it, see reconcile().
 		\param x desired movement on the X axis
 		\param y desired movement on the Y axis
-		\param time the actual timestamp (ticks), ignored
+		\param time the actual timestamp (ticks) to determine the elapsed time value since the last move
 	*/
 	void movePaddle(double x, double y, unsigned int time);
 
+	//! correct our predicted paddle by the server's position of it
+	/*! Starting from where the server has the paddle, the movements it hasn't applied yet are
+	    done once more, except those it should have by now, which got lost on the way (see isLost()).
+	    If it hasn't applied any yet, or they are too old to be kept, we keep ours while some are
+	    still on their way.
+		\param x the paddle's position as seen from our side
+		\param y the paddle's position
+		\param applied the sequence number of the latest movement the server applied
+	*/
+	void reconcile(double x, double y, unsigned int applied);
+
+	//! move the ball along the track the server sent, a little in the past
+	/*!	\param ticks elapsed time since the last call, ignored
+	*/
 	void updateGame(int ticks);
 
 	//! unused, see Server
@@ -51,6 +68,37 @@ private:
 	//! temporary placeholder for the player's name until the Player object is created (while data is transmitted)
 	std::string playername;
 
+	//! the WorldStates received lately, the bases of the next deltas
+	WorldHistory received;
+	//! the tick of the newest WorldState shown, older ones arriving late don't move the paddles back
+	unsigned int newest;
+	//! the ball's positions in the latest WorldStates, to show it smoothly
+	BallTrack track;
+
+	//! a paddle movement sent to the server
+	struct Move {
+		//! its sequence number, counting from 1
+		unsigned int seq;
+		//! the movement, quantized just as the server gets it
+		double x, y;
+		//! when it was made (ticks)
+		unsigned int time;
+	};
+	//! how many movements are kept, a bit more than half a second of steps
+	static const int MOVES = 80;
+	//! the latest movements, indexed by their sequence number modulo MOVES
+	Move moves[MOVES];
+	//! the sequence number of the latest movement
+	unsigned int moveseq;
+	//! our round trip to the server, from the latest ping (ms); 0 until measured
+	double roundtrip;
+
+	//! wether a movement the server hasn't applied got lost, as it would have been by now
+	/*! Until the round trip is measured, none is taken as lost.
+		\param move the movement
+	*/
+	bool isLost(const Move& move);
+
 	//! libgrapple client object, used for network communication
 	grapple_client client;
 };
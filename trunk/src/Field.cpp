@@ -1,5 +1,6 @@
 #include "Field.hpp"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include "Framework.hpp"
 
@@ -9,54 +10,63 @@ Field::Field(Framework *control)
 	wallTexture = framework->loadTexture("wall.png");
 }
 
-Collision* Field::detectCol(const Vec3f& position, const Vec3f& speed, double radius)
+/* time until a ball moving with speed from pos touches the plane at +-limit it is heading to;
+   0 if it is already touching or beyond, the biggest Scalar if it flies parallel */
+static Scalar planeImpact(Scalar pos, Scalar speed, Scalar limit)
 {
-	Collision *col = NULL;
+	if (speed == 0.0) return std::numeric_limits<Scalar>::max();
+	Scalar t = ((speed < 0.0 ? -limit : limit) - pos) / speed;
+	return std::max(t, Scalar(0.0));
+}
 
-	// first we make the "simple" z coord test
-	if (fabs(position.z) - radius > fabs(length/2.0))
-		return col;
+bool Field::detectCol(const Vec3f& position, const Vec3f& speed, Scalar radius, Scalar& time, Collision& col)
+{
+	// the ball's center touches a wall when it is radius away from it
+	Scalar tx = planeImpact(position.x, speed.x, width/2.0 - radius);
+	Scalar ty = planeImpact(position.y, speed.y, height/2.0 - radius);
+	Scalar impact = std::min(tx, ty);
 
-	// second we test against the planes
+	if (impact >= time)
+		return false;
 
-	// LEFT / RIGHT
-	double sign = (speed.x < 0 ? -1.0 : 1.0);
+	// the walls end where the field ends ("simple" z coord test)
+	Scalar z = position.z + speed.z * impact;
+	if (fabs(z) - radius > length/2.0)
+		return false;
 
-	if (fabs(position.x) + radius >= width/2.0)
-	{
-		// we could extend here with a test of the according circle against the rectangular
+	// we could extend here with a test of the according circle against the rectangular
 
-		col = new Collision;
-		col->position.y = position.y;
-		col->position.z = position.z;
-		col->speed.y = speed.y;
-		col->speed.z = speed.z;
+	col.position.x = position.x + speed.x * impact;
+	col.position.y = position.y + speed.y * impact;
+	col.position.z = z;
+	col.speed = speed;
+	col.opponent = this;
 
-		col->position.x = (width/2.0 - radius) * sign;
-		col->speed.x = -speed.x;
+	// LEFT / RIGHT (both, if we exactly hit an edge)
+	if (tx == impact) {
+		col.position.x = (width/2.0 - radius) * (speed.x < 0.0 ? -1.0 : 1.0);
+		col.speed.x = -speed.x;
 	}
-
 	// TOP / BOTTOM
-	sign = (speed.y < 0 ? -1.0 : 1.0);
+	if (ty == impact) {
+		col.position.y = (height/2.0 - radius) * (speed.y < 0.0 ? -1.0 : 1.0);
+		col.speed.y = -speed.y;
+	}
 
-	if (fabs(position.y) + radius >= height/2.0)
-	{
-		// we could extend here with a test of the according circle against the rectangular
+	time = impact;
+	return true;
+}
 
-		if (col == NULL) {
-			col = new Collision;
-			col->position.x = position.x;
-			col->position.z = position.z;
-			col->speed.x = speed.x;
-			col->speed.z = speed.z;
-		}
-		col->position.y = (height/2.0 - radius) * sign;
-		col->speed.y = -speed.y;
-	}
-	return col;
+Scalar Field::nextEvent(const Vec3f& position, const Vec3f& speed, Scalar radius)
+{
+	Scalar tx = planeImpact(position.x, speed.x, width/2.0 - radius);
+	Scalar ty = planeImpact(position.y, speed.y, height/2.0 - radius);
+	// zOutside() tells about a score once the ball is beyond this
+	Scalar tz = planeImpact(position.z, speed.z, length/2.0 + 1.0);
+	return std::min(std::min(tx, ty), tz);
 }
 
-Side Field::zOutside(double z)
+Side Field::zOutside(Scalar z)
 {
 	if (z < -length/2.0 - 1.0) return BACK;
 	if (z >  length/2.0 + 1.0) return FRONT;
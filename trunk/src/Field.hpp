@@ -17,20 +17,30 @@ public:
 	*/
 	Field(Framework *control);
 
-	//! test for collisions of a ball against the field walls
-	/*!	\param position the position to test for
-		\param speed the speed of the ball flying
+	//! sweep a ball against the field walls
+	/*!	\param position where the ball starts
+		\param speed the speed of the ball flying (units per second)
 		\param radius the ball's radius
-		\result pointer to a Collision structure which provides the according data, NULL if there was no collision
+		\param time how long the ball flies (seconds); if there is a collision before, it is set to the time of impact
+		\param col filled with the according data at the time of impact, untouched if there is no collision
+		\result wether there was a collision in time
 	*/
-	Collision* detectCol(const Vec3f& position, const Vec3f& speed, double radius);
+	bool detectCol(const Vec3f& position, const Vec3f& speed, Scalar radius, Scalar& time, Collision& col);
+
+	//! predict when a ball could next touch a wall or leave the field
+	/*!	\param position where the ball is
+		\param speed the speed of the ball flying (units per second)
+		\param radius the ball's radius
+		\result the time until then (seconds), 0 if it already could, the biggest Scalar if never
+	*/
+	Scalar nextEvent(const Vec3f& position, const Vec3f& speed, Scalar radius);
 
 	//! test wether the ball is inside of the field
 	/*! called by the global collision detector to become aware of a score
 		\param z the ball's position on the Z axis
 		\result FRONT or BACK if the ball is outside, otherwise NONE
 	*/
-	Side zOutside(double z);
+	Side zOutside(Scalar z);
 
 	//! draw the field using GL
 	void draw();
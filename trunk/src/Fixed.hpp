@@ -0,0 +1,78 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+
+//! A fixed point number, 20 of its 64 bits are behind the point
+/*! Built with -DFIXED_POINT (configure --enable-fixed-point), this is the Scalar the simulation
+    is computed with, see stuff.hpp. Everything is integer arithmetics then, which gives the very same
+    results on every CPU and with every compiler, so two machines simulating the same inputs stay
+    in step bit by bit.
+    Values up to about 8 million can be multiplied and divided, with a resolution of about 0.000001.
+    Doubles (and so constants) are converted implicitly; converting back needs toDouble(), which is
+    only meant for drawing and sending.
+*/
+class Fixed
+{
+public:
+	enum {
+		//! the number of bits behind the point
+		BITS = 20
+	};
+
+	//! The constructor, giving 0
+	inline Fixed() : raw(0) {}
+	//! The constructor, converting a double to the nearest fixed point number
+	inline Fixed(double value) : raw((int64_t)floor(value * (1 << BITS) + 0.5)) {}
+
+	//! returns a fixed point number from its raw bits
+	static inline Fixed fromRaw(int64_t r) { Fixed f; f.raw = r; return f; }
+	//! returns the raw bits
+	inline int64_t getRaw() const { return raw; }
+
+	inline Fixed& operator+=(Fixed b) { raw += b.raw; return *this; }
+	inline Fixed& operator-=(Fixed b) { raw -= b.raw; return *this; }
+	inline Fixed& operator*=(Fixed b) { raw = (raw * b.raw) >> BITS; return *this; }
+	inline Fixed& operator/=(Fixed b) { raw = raw * ((int64_t)1 << BITS) / b.raw; return *this; }
+
+	friend inline Fixed operator-(Fixed a) { return fromRaw(-a.raw); }
+	friend inline Fixed operator+(Fixed a, Fixed b) { return a += b; }
+	friend inline Fixed operator-(Fixed a, Fixed b) { return a -= b; }
+	friend inline Fixed operator*(Fixed a, Fixed b) { return a *= b; }
+	friend inline Fixed operator/(Fixed a, Fixed b) { return a /= b; }
+
+	friend inline bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+	friend inline bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+	friend inline bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+	friend inline bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+	friend inline bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+	friend inline bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+private:
+	//! the value times 2^BITS
+	int64_t raw;
+};
+
+//! returns the absolute value
+inline Fixed fabs(Fixed a) { return (a.getRaw() < 0 ? -a : a); }
+//! returns the biggest whole number not greater than a
+inline Fixed floor(Fixed a) { return Fixed::fromRaw(a.getRaw() & ~(((int64_t)1 << Fixed::BITS) - 1)); }
+//! returns a fixed point number as double
+inline double toDouble(Fixed a) { return a.getRaw() / (double)(1 << Fixed::BITS); }
+//! returns the whole part of a fixed point number, rounded down
+inline int toInt(Fixed a) { return (int)(a.getRaw() >> Fixed::BITS); }
+//! returns the raw bits of a fixed point number
+inline uint64_t toBits(Fixed a) { return (uint64_t)a.getRaw(); }
+
+namespace std {
+	//! the limits of Fixed, like those of the built in types
+	template<> class numeric_limits<Fixed> {
+	public:
+		static const bool is_specialized = true;
+		static inline Fixed min() { return Fixed::fromRaw(1); }
+		static inline Fixed max() { return Fixed::fromRaw(0x7fffffffffffffffLL); }
+	};
+}
+
+#endif
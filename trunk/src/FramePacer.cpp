@@ -0,0 +1,40 @@
+#include "FramePacer.hpp"
+#include <cmath>
+#include <algorithm>
+#include "SDL.h"
+
+FramePacer::FramePacer(Configuration::Pacing pacing, int fps, unsigned int now)
+ : mode(pacing), period(1000.0 / std::max(fps, 1)), deadline(now), overslept(0), sleeps(0)
+{
+}
+
+unsigned int FramePacer::wait()
+{
+	unsigned int now = SDL_GetTicks();
+	if (mode != Configuration::TARGET)
+		return now;
+
+	deadline += period;
+	// we fell behind by more than a frame, so rather drop it than rush
+	if (deadline < now - period)
+		deadline = now;
+
+	unsigned int wakeup = (unsigned int)ceil(deadline);
+	if ((int)(wakeup - now) > 0)
+	{
+		SDL_Delay(wakeup - now);
+		now = SDL_GetTicks();
+		if ((int)(now - wakeup) > 0)
+			overslept += now - wakeup;
+		sleeps++;
+	}
+	return now;
+}
+
+double FramePacer::takeOversleep()
+{
+	double average = (sleeps > 0 ? (double)overslept / sleeps : 0.0);
+	overslept = 0;
+	sleeps = 0;
+	return average;
+}
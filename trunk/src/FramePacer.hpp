@@ -0,0 +1,49 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include "stuff.hpp"
+
+//! Keeps the frames of a game loop in time, without spinning
+/*! In TARGET mode, the frames are due at a fixed rate; the deadlines are kept with fractions of
+    a tick, so 60 FPS don't become 62.5 FPS. Between two frames we sleep. SDL 1.2 can't wait for
+    events with a timeout, so the events arriving meanwhile are processed with the next frame,
+    which is at most a frame later.
+    Sleeping is never exact: the system wakes us up a little late, which is measured and reported
+    (see takeOversleep()). After a stall, the frames start over from now instead of rushing.
+    In VSYNC mode SDL_GL_SwapBuffers() waits for the display, and in UNCAPPED mode nobody waits
+    at all, so a benchmark sees the frame rate the machine can draw.
+*/
+class FramePacer
+{
+public:
+	//! The constructor
+	/*!	\param pacing how to pace the frames
+		\param fps the frames per second wanted in TARGET mode
+		\param now the actual time in ticks (ms)
+	*/
+	FramePacer(Configuration::Pacing pacing, int fps, unsigned int now);
+
+	//! wait until the next frame is due
+	/*!	\result the time in ticks (ms) the frame starts at
+	*/
+	unsigned int wait();
+
+	//! returns how late we woke up, on average, since the last call (ms)
+	double takeOversleep();
+
+	//! returns how the frames are paced
+	inline Configuration::Pacing getMode() { return mode; }
+private:
+	//! how the frames are paced
+	Configuration::Pacing mode;
+	//! the time between two frames in TARGET mode (ms)
+	double period;
+	//! when the next frame is due (ticks, with fractions)
+	double deadline;
+	//! ticks (ms) we woke up too late since the last takeOversleep()
+	unsigned int overslept;
+	//! how often we slept since the last takeOversleep()
+	unsigned int sleeps;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "FrameProfiler.hpp"
+#include <fstream>
+#include <algorithm>
+#include <sys/time.h>
+
+//! names of the phases, in the order of FrameProfiler::Phase
+static const char* names[FrameProfiler::PHASES] = { "events", "networking", "simulation", "drawing", "swap" };
+
+FrameProfiler::FrameProfiler()
+ : next(0), count(0), sorted(FRAMES)
+{
+	for (int p = 0; p < PHASES; p++)
+		actual[p] = 0;
+}
+
+double FrameProfiler::usecs()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+const char* FrameProfiler::getName(Phase phase)
+{
+	return names[phase];
+}
+
+void FrameProfiler::add(Phase phase, double begin)
+{
+	__sync_fetch_and_add(&actual[phase], (unsigned int)std::max(0.0, usecs() - begin));
+}
+
+void FrameProfiler::endFrame()
+{
+	for (int p = 0; p < PHASES; p++)
+		frame[next][p] = __sync_lock_test_and_set(&actual[p], 0);
+	next = (next + 1) % FRAMES;
+	count = std::min(count + 1, (unsigned int)FRAMES);
+}
+
+void FrameProfiler::getStats(Phase phase, unsigned int& p50, unsigned int& p99, unsigned int& max)
+{
+	p50 = p99 = max = 0;
+	if (count == 0) return;
+
+	for (unsigned int i = 0; i < count; i++)
+		sorted[i] = frame[i][phase];
+	std::vector<unsigned int>::iterator end = sorted.begin() + count;
+
+	std::nth_element(sorted.begin(), sorted.begin() + (count - 1) / 2, end);
+	p50 = sorted[(count - 1) / 2];
+	std::nth_element(sorted.begin(), sorted.begin() + (count - 1) * 99 / 100, end);
+	p99 = sorted[(count - 1) * 99 / 100];
+	max = *std::max_element(sorted.begin(), end);
+}
+
+bool FrameProfiler::dump(const std::string& filename)
+{
+	std::ofstream csv(filename.c_str());
+	if (!csv) return false;
+
+	csv << "frame";
+	for (int p = 0; p < PHASES; p++)
+		csv << "," << names[p] << "_us";
+	csv << "\n";
+
+	// while the ring isn't full, the oldest frame is the first one
+	unsigned int first = (count < FRAMES ? 0 : next);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int *f = frame[(first + i) % FRAMES];
+		csv << i;
+		for (int p = 0; p < PHASES; p++)
+			csv << "," << f[p];
+		csv << "\n";
+	}
+	return csv.good();
+}
@@ -0,0 +1,80 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <string>
+#include <vector>
+
+//! Notes how long the phases of every frame take
+/*! The latest frames are kept in a ring of fixed size, so nothing is allocated while playing.
+    The time spent in a phase is added up until the frame ends; the simulation thread adds its
+    networking and steps while the render thread draws, so a frame holds whatever the simulation
+    did meanwhile - nothing if the frames are faster than the steps, several steps if they are slower.
+    Without video output, a frame is a turn of the loop.
+*/
+class FrameProfiler
+{
+public:
+	//! the phases of a frame
+	enum Phase {
+		//! polling the SDL events
+		EVENTS,
+		//! doNetworking()
+		NETWORKING,
+		//! the simulation steps (updateGame())
+		SIMULATION,
+		//! drawScene()
+		DRAWING,
+		//! SDL_GL_SwapBuffers(), which may wait for the display
+		SWAP,
+		//! the number of phases
+		PHASES
+	};
+
+	//! how many frames are kept
+	enum { FRAMES = 512 };
+
+	//! The constructor
+	FrameProfiler();
+
+	//! wall clock in microseconds, to measure phases with
+	static double usecs();
+
+	//! returns the name of a phase, as shown and written to the CSV file
+	static const char* getName(Phase phase);
+
+	//! add time spent in a phase to the actual frame; may be called by any thread
+	/*!	\param phase the phase
+		\param begin when the phase started, see usecs()
+	*/
+	void add(Phase phase, double begin);
+
+	//! end the actual frame, keeping its phases in the ring; only called by one thread
+	void endFrame();
+
+	//! sum up a phase over the frames kept
+	/*!	\param phase the phase
+		\param p50 filled with the median (us)
+		\param p99 filled with the 99th percentile (us)
+		\param max filled with the maximum (us)
+	*/
+	void getStats(Phase phase, unsigned int& p50, unsigned int& p99, unsigned int& max);
+
+	//! write the frames kept to a CSV file, oldest first, one column per phase (us)
+	/*!	\param filename the file to write
+		\result wether it could be written
+	*/
+	bool dump(const std::string& filename);
+private:
+	//! time spent in every phase of the actual frame (us), added to atomically
+	volatile unsigned int actual[PHASES];
+	//! the phases of the latest frames (us), used as a ring
+	unsigned int frame[FRAMES][PHASES];
+	//! where the next frame goes
+	unsigned int next;
+	//! how many frames were kept, up to FRAMES
+	unsigned int count;
+	//! room for the percentiles, so getStats() doesn't allocate
+	std::vector<unsigned int> sorted;
+};
+
+#endif
@@ -7,42 +7,92 @@
 
 
 Framework::Framework(void *surf, const Configuration& conf, Networkstate initial)
- : field(this), output(this), surface((SDL_Surface*)surf),
-   paused(1), timeunit(7), lasttime(SDL_GetTicks()), frames(0), state(initial), xdiff(0), camera(conf.width, conf.height)
+ : headless(conf.dedicated), field(this), output(this), surface((SDL_Surface*)surf),
+   paused(1), timestep(8), maxsteps(5), lasttime(SDL_GetTicks()), lastframe(lasttime),
+   frames(0), state(initial), xdiff(0), cpulast(clock()), timers(SDL_GetTicks()), finished(false),
+   pacer(headless ? Configuration::TARGET : conf.pacing, headless ? 1000 / timestep : conf.fps, lasttime),
+   camera(conf.width, conf.height), profilefile(conf.profile)
 {
-	/* initialize OpenGL */
-	resetGL();
+	if (!headless)
+	{
+		/* initialize OpenGL */
+		resetGL();
 
-	/* set up the window */
-	camera.init();
+		/* set up the window */
+		camera.init();
 
-	if (conf.fullscreen) SDL_WM_ToggleFullScreen(surface);
+		if (conf.fullscreen) SDL_WM_ToggleFullScreen(surface);
+	}
 
-	/* set unpaused state (grab input) */
+	/* set unpaused state, the render thread grabs the input then */
 	togglePause(false, true);
+
+	inputlock = SDL_CreateMutex();
 }
 
 Framework::~Framework()
 {
-	for (int i = 0; i < timerdata.size(); i++)
-	{
-		if (timerdata[i]->timer != NULL)
-			SDL_RemoveTimer(timerdata[i]->timer);
-		delete timerdata[i];
-	}
+	SDL_DestroyMutex(inputlock);
 }
 
 void Framework::loop()
 {
-	/* main loop variable */
-	bool done = false;
 	/* used to collect events */
 	SDL_Event event;
 
-	/* wait for events */
-	while (!done)
+	if (headless) {
+		/* there is nothing to draw, the pacer wakes us up once per step */
+		while (!finished)
+		{
+			unsigned int now = pacer.wait();
+
+			/* only quitting can happen here */
+			double begin = FrameProfiler::usecs();
+			while (SDL_PollEvent(&event))
+				if (event.type == SDL_QUIT) shutdown();
+			profiler.add(FrameProfiler::EVENTS, begin);
+
+			begin = FrameProfiler::usecs();
+			doNetworking();
+			profiler.add(FrameProfiler::NETWORKING, begin);
+
+			begin = FrameProfiler::usecs();
+			timers.advance(now);
+			int steps = simulate(now);
+			profiler.add(FrameProfiler::SIMULATION, begin);
+			profiler.endFrame();
+
+			frames += steps;
+			xdiff += steps * timestep;
+			if (xdiff >= 10000) {
+				reportLoad(frames, xdiff, pacer.takeOversleep());
+				frames = 0;
+				xdiff = 0;
+			}
+		}
+		dumpProfile();
+		return;
+	}
+
+	/* the simulation runs on, its own pace, while we draw */
+	publish();
+	SDL_Thread *thread = SDL_CreateThread(simulation, this);
+	if (thread == NULL) {
+		std::cerr << "can't start the simulation thread: " << SDL_GetError() << std::endl;
+		return;
+	}
+
+	/* wether the mouse is grabbed, which follows the pause */
+	bool grabbed = false;
+
+	const Snapshot *shot = &snapshots.take();
+	while (!shot->finished)
 	{
+		/* sleep until the next frame is due */
+		unsigned int now = pacer.wait();
+
 		/* handle the events in the queue */
+		double begin = FrameProfiler::usecs();
 		while (SDL_PollEvent(&event))
 		{
 			switch(event.type)
@@ -54,47 +104,174 @@ void Framework::loop()
 			case SDL_MOUSEBUTTONUP:
 				/* handle mouse button release for serving */
 				if (event.button.button == SDL_BUTTON_LEFT)
-					if (!paused) serveBall();
+					pushInput(Input::SERVE);
+				break;
 			case SDL_KEYDOWN:
 				/* handle key presses */
 				handleKeyPress(&event.key.keysym);
 				break;
 			case SDL_QUIT:
 				/* handle quit requests */
-				done = true;
-				break;
-			case SDL_USEREVENT:
-				if (((TimerData*)event.user.data1)->timer == NULL)
-				{
-					/* this means our timer has gone inactive and we are pleased to stop our work! */
-				} else {
-					((TimerData*)event.user.data1)->receiver->action(((TimerData*)event.user.data1)->event);
-				}
+				pushInput(Input::QUIT);
 				break;
 			}
 		}
-		int tdiff = SDL_GetTicks() - lasttime;
-		if (tdiff > timeunit) {
-			frames++;
-			xdiff += tdiff; // always greater 0 because we decided to let tdiff be greater than timeunit
-			if ((xdiff >= 500)&&(xdiff >= timeunit * 25)) {
-				output.updateFPS(frames * 1000.0 / xdiff); // There are 1000 ticks / second
-				frames = 0;
-				xdiff = 0;
-				ping();
-			}
-			lasttime += tdiff;
+		profiler.add(FrameProfiler::EVENTS, begin);
 
-			// Multiplayer code
-			doNetworking();
+		shot = &snapshots.take();
+
+		/* show the cursor while paused or connecting */
+		bool grab = (!shot->hud.paused)&&(!shot->connecting);
+		if (grab != grabbed) {
+			SDL_ShowCursor(grab ? 0 : 1);
+			SDL_WM_GrabInput(grab ? SDL_GRAB_ON : SDL_GRAB_OFF);
+			grabbed = grab;
+		}
+
+		frames++;
+		xdiff += now - lastframe;
+		if (xdiff >= 500) {
+			output.updateFPS(frames * 1000.0 / xdiff, pacer.takeOversleep()); // There are 1000 ticks / second
+			if (output.isProfileShown())
+				output.updateProfile(profiler);
+			frames = 0;
+			xdiff = 0;
+		}
+		lastframe = now;
+
+		// Rendering code, somewhere between the last two steps
+		begin = FrameProfiler::usecs();
+		double alpha = std::max(0, (int)(now - shot->time)) / (double)timestep;
+		drawScene(*shot, std::min(alpha, 1.0));
+		profiler.add(FrameProfiler::DRAWING, begin);
+
+		/* Draw it to the screen */
+		begin = FrameProfiler::usecs();
+		SDL_GL_SwapBuffers();
+		profiler.add(FrameProfiler::SWAP, begin);
+		profiler.endFrame();
+	}
+
+	SDL_WaitThread(thread, NULL);
+	dumpProfile();
+}
+
+void Framework::dumpProfile()
+{
+	if (profilefile.empty()) return;
+
+	if (profiler.dump(profilefile))
+		std::cout << "frame profile written to " << profilefile << std::endl;
+	else	std::cerr << "can't write the frame profile to " << profilefile << std::endl;
+}
+
+int Framework::simulation(void *game)
+{
+	((Framework*)game)->runSimulation();
+	return 0;
+}
+
+void Framework::runSimulation()
+{
+	/* one wakeup per step, however fast the frames are */
+	FramePacer steps(Configuration::TARGET, 1000 / timestep, SDL_GetTicks());
+	unsigned int lastping = SDL_GetTicks();
+
+	while (!finished)
+	{
+		unsigned int now = steps.wait();
+
+		// Multiplayer code
+		double begin = FrameProfiler::usecs();
+		doNetworking();
+		profiler.add(FrameProfiler::NETWORKING, begin);
+
+		// Game status code, in as many fixed steps as are due
+		begin = FrameProfiler::usecs();
+		processInput();
+		timers.advance(now);
+		simulate(now);
+		profiler.add(FrameProfiler::SIMULATION, begin);
+
+		if (now - lastping >= 500) {
+			ping();
+			lastping = now;
+		}
+		publish();
+	}
+	/* lets the render thread know we're done */
+	publish();
+}
+
+void Framework::publish()
+{
+	Snapshot& shot = snapshots.getBack();
+	shot.time = lasttime;
+	shot.finished = finished;
+	shot.connecting = (state == CONNECTING);
+	shot.ball.resize(ball.size());
+	for (int i = 0; i < ball.size(); i++)
+		ball[i].takeSnapshot(shot.ball[i]);
+	shot.paddle.resize(player.size());
+	for (int i = 0; i < player.size(); i++)
+		player[i]->takeSnapshot(shot.paddle[i]);
+	multiball.takeSnapshot(shot.swarm);
+	shot.hud = output.getHud();
+	snapshots.publish();
+}
+
+void Framework::pushInput(Input::Type type, double x, double y)
+{
+	Input in;
+	in.type = type;
+	in.x = x;
+	in.y = y;
+	in.time = SDL_GetTicks();
+	SDL_mutexP(inputlock);
+	if ((type == Input::MOVE)&&(!input.empty())&&(input.back().type == Input::MOVE)) {
+		input.back().x += x;
+		input.back().y += y;
+		input.back().time = in.time;
+	} else	input.push_back(in);
+	SDL_mutexV(inputlock);
+}
 
-			// Game status code
-			updateGame(tdiff);
+void Framework::processInput()
+{
+	SDL_mutexP(inputlock);
+	input.swap(pending);
+	SDL_mutexV(inputlock);
+
+	// the movement first, in one go; a serve then sees the paddle's latest speed
+	double x = 0.0, y = 0.0;
+	unsigned int time = 0;
+	for (int i = 0; i < pending.size(); i++)
+		if (pending[i].type == Input::MOVE) {
+			x += pending[i].x;
+			y += pending[i].y;
+			time = pending[i].time;
+		}
+	if ((time != 0)&&(!paused)) movePaddle(x, y, time);
 
-			// Rendering code
-			drawScene();
+	for (int i = 0; i < pending.size(); i++)
+	{
+		const Input& in = pending[i];
+		switch (in.type)
+		{
+		case Input::MOVE:
+			break;
+		case Input::SERVE:
+			if (!paused) serveBall();
+			break;
+		case Input::PAUSE:
+			togglePause(false, false);
+			break;
+		case Input::QUIT:
+			shutdown();
+			break;
 		}
 	}
+	pending.clear();
 }
 
 /* function to handle key press events */
@@ -103,14 +280,14 @@ void Framework::handleKeyPress(SDL_keysym *keysym)
 	switch (keysym->sym)
 	{
 	case SDLK_q:
-		shutdown();
+		pushInput(Input::QUIT);
 		break;
 	case SDLK_f:
 		SDL_WM_ToggleFullScreen(surface);
 		break;
 	case SDLK_ESCAPE:
 	case SDLK_p:
-		togglePause(false, false);
+		pushInput(Input::PAUSE);
 		break;
 	case SDLK_F1:
 		camera.setMode((Camera::View)1);
@@ -121,6 +298,10 @@ void Framework::handleKeyPress(SDL_keysym *keysym)
 	case SDLK_F3:
 		camera.setMode((Camera::View)3);
 		break;
+	case SDLK_t:
+		output.toggleProfile();
+		output.updateProfile(profiler);
+		break;
 	default:
 		break;
 	}
@@ -136,7 +317,7 @@ void Framework::handleMouseMove(int x, int y, unsigned char buttons)
 		camera.adjustDistance((double)y / 10.0);
 		resetGL();
 	} else {
-		if (!paused) movePaddle((double)x / 50.0, (double)-y / 50.0, SDL_GetTicks());
+		pushInput(Input::MOVE, (double)x / 50.0, (double)-y / 50.0);
 		if (camera.getMode() == Camera::FOLLOW_PADDLE)
 			camera.adjustAngle((double)-x / 20.0, (double)-y / 20.0);
 		else if (camera.getMode() == Camera::FOLLOW_PADDLE_REVERSE)
@@ -150,17 +331,12 @@ void Framework::togglePause(bool pause, bool external)
 	if ((((external)&&(pause))||((!external)&&(paused == 0)))&&(state != CONNECTING))
 	{
 		paused = SDL_GetTicks() - lasttime;
-		SDL_ShowCursor(1);
-		SDL_WM_GrabInput(SDL_GRAB_OFF);
 		output.togglePaused(true);
 		t = PAUSE_REQUEST;
 	} else {
-		lasttime = SDL_GetTicks() + paused;
+		// the simulation goes on with the time it had left before the pause
+		lasttime = SDL_GetTicks() - paused;
 		paused = 0;
-		if (state != CONNECTING) {
-			SDL_ShowCursor(0);
-			SDL_WM_GrabInput(SDL_GRAB_ON);
-		}
 		output.togglePaused(false);
 		t = RESUME_REQUEST;
 	}
@@ -173,6 +349,10 @@ GLuint Framework::loadTexture(const std::string& filename)
 {
 	std::string fullname = std::string(PATH_PREFIX) + filename;
 	GLuint texture = 0;
+
+	/* without a GL context there is nothing to upload to */
+	if (headless) return texture;
+
 	/* Create temporal storage space for the texture */
 	SDL_Surface *image;
 
@@ -295,15 +475,18 @@ void Framework::resetGL()
 }
 
 /* Here goes our drawing code */
-void Framework::drawScene()
+void Framework::drawScene(const Snapshot& shot, double alpha)
 {
 	/* Clear the Buffers */
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-	output.drawBackground((paused)||(state == CONNECTING));
+	output.drawBackground((shot.hud.paused)||(shot.connecting));
 
-	if (state != CONNECTING)
+	if (!shot.connecting)
 	{
+		/* the balls' shrinking and growing goes along with the position drawn */
+		double time = shot.time - (1.0 - alpha) * timestep;
+
 		camera.translate();
 
 		/* while we draw into the stencil buffer to store where the walls are to be overdrawn
@@ -339,22 +522,22 @@ void Framework::drawScene()
 
 		glScalef(1.0, -1.0, 1.0);
 		glTranslatef(0.0, field.getHeight(),0.0);
-		for (int i = 0; i < ball.size(); i++)	ball[i].draw();
+		for (int i = 0; i < shot.ball.size(); i++)	Ball::draw(shot.ball[i], alpha, time);
 
 		camera.translate();
 		glScalef(1.0, -1.0, 1.0);
 		glTranslatef(0.0, -field.getHeight(),0.0);
-		for (int i = 0; i < ball.size(); i++)	ball[i].draw();
+		for (int i = 0; i < shot.ball.size(); i++)	Ball::draw(shot.ball[i], alpha, time);
 
 		camera.translate();
 		glScalef(-1.0, 1.0, 1.0);
 		glTranslatef(field.getWidth(), 0.0,0.0);
-		for (int i = 0; i < ball.size(); i++)	ball[i].draw();
+		for (int i = 0; i < shot.ball.size(); i++)	Ball::draw(shot.ball[i], alpha, time);
 
 		camera.translate();
 		glScalef(-1.0, 1.0, 1.0);
 		glTranslatef(-field.getWidth(), 0.0, 0.0);
-		for (int i = 0; i < ball.size(); i++)	ball[i].draw();
+		for (int i = 0; i < shot.ball.size(); i++)	Ball::draw(shot.ball[i], alpha, time);
 
 		glDisable(GL_STENCIL_TEST);
 		glPopMatrix();
@@ -373,81 +556,116 @@ void Framework::drawScene()
 
 		// finally we want to see the balls themselves, too
 
-		for (int i = 0; i < ball.size(); i++)	ball[i].draw();
+		for (int i = 0; i < shot.ball.size(); i++)	Ball::draw(shot.ball[i], alpha, time);
+		// (the swarm is left out of the reflections, it can have thousands of balls)
+		multiball.draw(shot.swarm, alpha);
 
 		// we conclude with translucent objects, first in the back:
 
-		for (int i = 0; i < player.size(); i++)
-			if (player[i]->getSide() == BACK) player[i]->draw();
+		for (int i = 0; i < shot.paddle.size(); i++)
+			if (shot.paddle[i].side == BACK) Player::draw(shot.paddle[i]);
 
 		// next the ones in the front:
 
-		for (int i = 0; i < player.size(); i++)
-			if (player[i]->getSide() == FRONT) player[i]->draw();
+		for (int i = 0; i < shot.paddle.size(); i++)
+			if (shot.paddle[i].side == FRONT) Player::draw(shot.paddle[i]);
 
 		// these are overlays
-		output.drawScore();
-		output.drawRound();
+		output.drawScore(shot.hud, shot.paddle);
+		output.drawRound(shot.hud);
 	}
-	output.drawFPS();
-	output.drawMessages();
+	output.drawFPS(shot.hud);
+	output.drawProfile();
+	output.drawMessages(shot.hud, shot.time);
+}
 
-	/* Draw it to the screen */
-	SDL_GL_SwapBuffers();
+bool Framework::tick(unsigned int now)
+{
+	timers.advance(now);
+	doNetworking();
+	simulate(now);
+	return !finished;
 }
 
-Collision* Framework::detectCol(const Vec3f& position, const Vec3f& speed, double radius)
+int Framework::simulate(unsigned int now)
 {
-	Collision* col;
+	int behind = now - lasttime;
+	if (behind < (int)timestep)
+		return 0;
+
+	/* after a stall we rather drop time than spend even more of it catching up */
+	int steps = behind / timestep;
+	if (steps > maxsteps) {
+		steps = maxsteps;
+		lasttime = now - steps * timestep;
+	}
 
+	for (int i = 0; i < steps; i++)
+	{
+		updateGame(timestep);
+		lasttime += timestep;
+	}
+	return steps;
+}
+
+void Framework::reportLoad(unsigned int ticks, unsigned int elapsed, double oversleep)
+{
+	clock_t now = clock();
+	// processor time in ms, including the networking threads
+	double cpu = 1000.0 * (double)(now - cpulast) / CLOCKS_PER_SEC;
+	cpulast = now;
+
+	std::cout << "Load: " << round(ticks * 10000.0 / elapsed) / 10.0 << " ticks/s, "
+		<< round(cpu * 1000.0 / ticks) << " us cpu per tick, "
+		<< round(cpu * 1000.0 / elapsed) / 10.0 << "% of a core, "
+		<< round(oversleep * 10.0) / 10.0 << " ms overslept per tick" << std::endl;
+}
+
+bool Framework::detectCol(const Vec3f& position, const Vec3f& speed, Scalar radius, Scalar& time, Collision& col)
+{
 	// test against walls
-	col = field.detectCol(position, speed, radius);
-	if (col != NULL) return col;
+	bool hit = field.detectCol(position, speed, radius, time, col);
 
-	// detection for paddles
+	// detection for paddles; they only report (and overwrite col with) hits earlier than the one we already have
 	for (int i = 0; i < player.size(); i++)
-	{
-		col = player[i]->detectCol(position, speed, radius);
-		if (col != NULL) return col;
-	}
+		hit |= player[i]->detectCol(position, speed, radius, time, col);
+	if (hit) return true;
 
 	// wether the ball is still inside?
-	Side side = field.zOutside(position.z);
+	Side side = field.zOutside(position.z + speed.z * time);
 	if (side != NONE)
 		// doScore() detects itself if it's called multiple times
 		doScore(side);
-	return NULL;
+	return false;
+}
+
+Scalar Framework::nextEvent(const Vec3f& position, const Vec3f& speed, Scalar radius)
+{
+	Scalar time = field.nextEvent(position, speed, radius);
+	for (int i = 0; i < player.size(); i++)
+		time = std::min(time, player[i]->nextEvent(position, speed, radius));
+	return time;
 }
 
-double Framework::detectBarrier(double dest, int direction, Side side)
+Scalar Framework::detectBarrier(Scalar dest, int direction, Side side)
 {
 	switch (direction) {
-	case LEFT:	return std::max(dest, -field.getWidth()/2.0f);
-	case RIGHT:	return std::min(dest,  field.getWidth()/2.0f);
-	case TOP:	return std::max(dest, -field.getHeight()/2.0f);
-	case BOTTOM:	return std::min(dest,  field.getHeight()/2.0f);
-	default:	return INFINITY;
+	case LEFT:	return std::max(dest, Scalar(-field.getWidth()/2.0));
+	case RIGHT:	return std::min(dest, Scalar( field.getWidth()/2.0));
+	case TOP:	return std::max(dest, Scalar(-field.getHeight()/2.0));
+	case BOTTOM:	return std::min(dest, Scalar( field.getHeight()/2.0));
+	default:	return std::numeric_limits<Scalar>::max();
 	}
 }
 
 int Framework::addTimer(unsigned int intervall, EventReceiver::Event event, EventReceiver* receiver)
 {
-	TimerData* data = new TimerData;
-	data->event = event;
-	data->receiver = receiver;
-	data->timer = SDL_AddTimer(intervall, processTimer, data);
-	timerdata.push_back(data);
-	return timerdata.size() - 1;
+	return timers.add(intervall, event, receiver);
 }
 
-void Framework::removeTimer(int index)
+void Framework::removeTimer(int handle)
 {
-	SDL_RemoveTimer(timerdata[index]->timer);
-	timerdata[index]->timer = NULL;
-	/* we are NOT allowed to delete the TimerData object, because it could be pointed to by
-	   a currently running timer. it has to check wether it's SDL Timer still exists
-	   and kill itself if not.
-	*/
+	timers.remove(handle);
 }
 
 void Framework::sendSimplePacket(PacketType t)
@@ -459,16 +677,5 @@ void Framework::sendSimplePacket(PacketType t)
 
 void Framework::shutdown()
 {
-	SDL_Event killer;
-	killer.type = SDL_QUIT;
-	SDL_PushEvent(&killer);
-}
-
-unsigned int processTimer(unsigned int intervall, void* data)
-{
-	SDL_Event event;
-	event.type= SDL_USEREVENT;
-	event.user.data1 = data;
-	SDL_PushEvent(&event);
-	return intervall;
+	finished = true;
 }
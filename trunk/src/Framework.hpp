@@ -5,8 +5,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <ctime>
 
 #include "SDL.h"
+#include "SDL_thread.h"
 #include <GL/gl.h>
 #include "grapple/grapple.h"
 
@@ -14,9 +16,15 @@
 #include "Interface.hpp"
 #include "Field.hpp"
 #include "Ball.hpp"
+#include "Multiball.hpp"
 #include "Player.hpp"
 #include "Camera.hpp"
 #include "Buffer.hpp"
+#include "TimerWheel.hpp"
+#include "FramePacer.hpp"
+#include "SnapshotBuffer.hpp"
+#include "FrameProfiler.hpp"
+#include "RateControl.hpp"
 
 class Ball;
 
@@ -30,25 +38,25 @@ class Player;
 class Framework {
 
 public:
-	//! holds a timer call
-	struct TimerData {
-		//! the event descriptor
-		EventReceiver::Event event;
-		//! the receiving object who demanded the timer
-		EventReceiver* receiver;
-		//! the timer itself provided by the SDL
-		SDL_TimerID timer;
-	};
-
 	struct Peer {
 		std::string name;
 		Player* player;
 		bool ready;
+		//! the tick of the latest WorldState the peer acknowledged, 0 for none
+		unsigned int acked;
+		//! the sequence number of the peer's latest paddle movement applied, 0 for none
+		unsigned int moved;
+		//! WorldStates sent to the peer since the last bandwidth report, keyframes of them, and their bytes
+		unsigned int states, keyframes, bytes;
+		//! balls which passed the peer's paddle since the last report, and how many of them hit it rewound
+		unsigned int rewinds, saves;
+		//! how often the peer gets a WorldState
+		RateControl rate;
 
 		inline Peer(std::string id)
-		: name(id), player(NULL), ready(false) {}
+		: name(id), player(NULL), ready(false), acked(0), moved(0), states(0), keyframes(0), bytes(0), rewinds(0), saves(0) {}
 		// needed by std::map, do not use
-		inline Peer() {}
+		inline Peer() : player(NULL), ready(false), acked(0), moved(0), states(0), keyframes(0), bytes(0), rewinds(0), saves(0) {}
 	};
 
 	//! holds the actual networking state
@@ -66,9 +74,10 @@ public:
 	} state;
 
 	//! shutdown the game
-	/*! This will push a quit event and is called whenever we want to exit cleanly.
+	/*! This will end loop() (or make tick() return false) and is called whenever we want to exit cleanly.
 	   We need to exit that way because using exit() wouldn't call destructors,
-	   therefore the opposite player wouldn't get told about quitting. */
+	   therefore the opposite player wouldn't get told about quitting.
+	   Other games hosted in the same process go on. */
 	void shutdown();
 
 	//! the constructor, called by Server or Client
@@ -78,8 +87,23 @@ public:
 	*/
 	Framework(void *surf, const Configuration& conf, Networkstate initial);
 
-	//! the destructor only frees left SDL timers and the TimerData structures
-	~Framework();
+	//! the destructor, virtual as the Scheduler deletes the games it hosts
+	virtual ~Framework();
+
+	//! enter the event loop, which runs and processes events until the game is shut down
+	/*! With video output, the simulation runs on a thread of its own, see runSimulation(),
+	    while this one pumps the SDL events and draws the latest Snapshot. SDL 1.2 wants both
+	    done by the thread which set the video mode.
+	*/
+	void loop();
+
+	//! do everything due until now once: timer events, networking and simulation steps
+	/*! Used instead of loop() when several games share one process, see Scheduler.
+	    No SDL events are processed here, as they are meant for the whole process.
+		\param now the actual time in ticks (ms)
+		\result false once the game has been shut down
+	*/
+	bool tick(unsigned int now);
 
 	//! load a texture into OpenGL
 	/*!	\param filename the file containing the texture (has to be readable by SDL_image)
@@ -87,13 +111,26 @@ public:
 	*/
 	GLuint loadTexture(const std::string& filename);
 
-	//! test for collisions of a ball against the world
-	/*!	\param position the position to test for
-		\param speed the speed of the ball flying
+	//! sweep a ball through the world
+	/*! Finds the first thing the ball bumps into while flying for the given time.
+	    If there is nothing, the ball is tested for a score at its destination.
+		\param position where the ball starts
+		\param speed the speed of the ball flying (units per second)
+		\param radius the ball's radius
+		\param time how long the ball flies (seconds); if there is a collision before, it is set to the time of impact
+		\param col filled with the according data at the time of impact, untouched if the ball flies freely
+		\result wether there was a collision in time
+	*/
+	bool detectCol(const Vec3f& position, const Vec3f& speed, Scalar radius, Scalar& time, Collision& col);
+
+	//! predict the next event of a ball: a wall, a paddle's level or a score
+	/*! Until then the ball flies straight and detectCol() can't find anything.
+		\param position where the ball is
+		\param speed the speed of the ball flying (units per second)
 		\param radius the ball's radius
-		\result pointer to a Collision structure which provides the according data
+		\result the time until the event (seconds), 0 if it could be now, the biggest Scalar if never
 	*/
-	Collision* detectCol(const Vec3f& position, const Vec3f& speed, double radius);
+	Scalar nextEvent(const Vec3f& position, const Vec3f& speed, Scalar radius);
 
 	//! test for something in the way, paddle movement
 	/*! only tests for one direction (x or y axis) at once
@@ -102,26 +139,32 @@ public:
 		\param side wether the paddle is in the FRONT or in the BACK
 		\result how far the paddle can go without crossing a barriere
 	*/
-	double detectBarrier(double dest, int direction, Side side);
+	Scalar detectBarrier(Scalar dest, int direction, Side side);
 
-	//! add a timer (in fact SDL timer)
-	/*!	\param intervall the intervall in ticks (ms) of the wanted timer
+	//! add a timer, which triggers its event every intervall until it's removed
+	/*! The events are processed by loop() or tick(), see TimerWheel.
+		\param intervall the intervall in ticks (ms) of the wanted timer
 		\param event the event the timer should trigger
 		\param receiver pointer to the receiving object
-		\result the timer's number needed later to remove the timer
+		\result the timer's handle needed later to remove the timer
 	*/
 	int addTimer(unsigned int intervall, EventReceiver::Event event, EventReceiver* receiver);
 
-	//! remove a previously added timer by it's index
-	/*!	\param index the timer's number which was given by addTimer()
+	//! remove a previously added timer by it's handle
+	/*!	\param handle the timer's handle which was given by addTimer(); if it's already removed, nothing happens
 	*/
-	void removeTimer(int index);
+	void removeTimer(int handle);
+
+	//! returns the length of a simulation step in ticks (ms)
+	inline unsigned int getTimestep() { return timestep; }
+	//! returns the time in ticks (ms) the simulation has reached
+	inline unsigned int getTime() { return lasttime; }
 
 	inline const std::vector<Player*>& getPlayers() { return player; }
-protected:
-	//! enter the event loop, which indefinitely runs and processes events
-	void loop();
 
+	//! wether we run without any video output, i.e. as a dedicated server
+	inline bool isHeadless() { return headless; }
+protected:
 	//! set/unset pause state
 	/*! In pause mode, the mouse & keyboard input isn't grabbed and the game can't go on.
 	    Pause mode is shared between Server and Client.
@@ -139,6 +182,12 @@ protected:
 
 	void sendSimplePacket(PacketType t);
 
+	//! wether we run without any video output
+	/*! In headless mode there is no SDL surface and no GL context: nothing gets drawn,
+	    no textures are loaded and loop() sleeps between fixed simulation ticks.
+	    Declared before the members below as they already ask for it while being constructed. */
+	bool headless;
+
 	//! our Camera object setting up the viewport
 	Camera camera;
 
@@ -153,10 +202,14 @@ protected:
 	*/
 	std::vector<Ball> ball;
 
+	//! the swarm of additional balls in multiball mode
+	/*! They only fly around on the Server, nobody scores with them. */
+	Multiball multiball;
+
 	//! vector holding all involved players (with their paddles).
 	/*! Up till now we have only two players.
-		If noone is connected as client, the server provides the famous "Mr. Wand" called opponent.
-		Better not try to beat him!
+		If noone is connected as client, the server provides the famous "Mr. Wand" called opponent,
+		see Bot. Better not try to beat him!
 	*/
 	std::vector<Player*> player;
 
@@ -170,10 +223,79 @@ private:
 	//! initialize GL
 	void resetGL();
 
-	//! draw the whole scene; called by loop() on every frame
-	void drawScene();
+	//! game input, noted by the render thread and processed by the simulation thread
+	struct Input {
+		enum Type {
+			//! move the paddle by x, y
+			MOVE,
+			//! serve the ball
+			SERVE,
+			//! toggle the pause
+			PAUSE,
+			//! shut the game down
+			QUIT
+		} type;
+		//! the movement, for MOVE only
+		double x, y;
+		//! when it happened (ticks)
+		unsigned int time;
+	};
+
+	//! draw the whole scene; called by loop() on every frame, which swaps it to the screen then
+	/*! \param shot the state to draw
+		\param alpha how far the time drawn lies between the last two simulation steps (0..1)
+	*/
+	void drawScene(const Snapshot& shot, double alpha);
+
+	//! note what is to be drawn into the SnapshotBuffer, called by the simulation thread
+	void publish();
+
+	//! entry point of the simulation thread, see runSimulation()
+	/*! \param game the Framework to run
+		\result always 0
+	*/
+	static int simulation(void *game);
+
+	//! the simulation thread: do the input, timers, networking and steps due, until the game is shut down
+	/*! Wakes up once per step and publishes a Snapshot after it, no matter how long frames take.
+	*/
+	void runSimulation();
+
+	//! hand game input over to the simulation thread, called by the render thread
+	/*! A MOVE right after another one is added to it, so the queue doesn't grow with the mouse's rate.
+		\param type what happened
+		\param x movement, X axis (MOVE only)
+		\param y movement, Y axis (MOVE only)
+	*/
+	void pushInput(Input::Type type, double x = 0.0, double y = 0.0);
+
+	//! process the input handed over by pushInput(), called by the simulation thread
+	/*! All the paddle movement is summed up and given to movePaddle() at once, so the
+	    paddle moves (and its position is sent) once per step, no matter how fast the mouse reports.
+	*/
+	void processInput();
+
+	//! run the simulation steps due until now, called by loop() and tick()
+	/*! The game always moves on in steps of timestep, no matter how fast we draw, so it
+	    behaves the same on every machine. After a stall, no more than maxsteps are done
+	    and the remaining time is dropped.
+		\param now the actual time in ticks (ms)
+		\result the number of steps done
+	*/
+	int simulate(unsigned int now);
+
+	//! print the simulation's cpu usage, called by loop() in headless mode
+	/*!	\param ticks simulation ticks done since the last report
+		\param elapsed ticks (ms) passed since the last report
+		\param oversleep how late the FramePacer woke up for a tick, on average (ms)
+	*/
+	void reportLoad(unsigned int ticks, unsigned int elapsed, double oversleep);
+
+	//! write the frame profile to the file given in the Configuration, if any; called when loop() ends
+	void dumpProfile();
 
 	//! processe a pressed key, called by loop()
+	/*! Camera and window are changed right away, anything else is given to pushInput(). */
 	void handleKeyPress(SDL_keysym *keysym);
 
 	//! processe mouse movement, called by loop()
@@ -184,36 +306,51 @@ private:
 	*/
 	void handleMouseMove(int x, int y, unsigned char buttons);
 
-	//! move the paddle, called by handleMouseMove()
+	//! move the paddle, called by processInput()
 	virtual void movePaddle(double x, double y, unsigned int time)=0;
 	//! update the game per frame, therefore called by loop()
 	virtual void updateGame(int ticks)=0;
 	//! process an occured score (the ball went out of the field), called by detectCol()
 	virtual void doScore(Side side)=0;
-	//! serve the ball, i.e. the player wants to kick it off, called by loop()
+	//! serve the ball, i.e. the player wants to kick it off, called by processInput()
 	virtual void serveBall()=0;
 
 	/*! the SDL video surface */
 	SDL_Surface *surface;
 
-	//! vector holding the TimerData structures; they have to be held to remove timers and free them
-	std::vector<TimerData*> timerdata;
+	//! the timers, processed by loop() and tick()
+	TimerWheel timers;
+	//! set by shutdown()
+	bool finished;
 
-	//! the minimum stepping in ticks (ms) - can be used to achieve a fps maximum setting
-	unsigned int timeunit;
-	//! time in ticks (ms) of the latest frame
+	//! length of a simulation step in ticks (ms), 125 Hz - as close to 120 Hz as whole ticks get
+	unsigned int timestep;
+	//! the most simulation steps to catch up with in one go
+	int maxsteps;
+	//! time in ticks (ms) the simulation has reached
 	unsigned int lasttime;
+	//! time in ticks (ms) of the latest frame
+	unsigned int lastframe;
 	//! frames we did since the last fps calculation
 	unsigned int frames;
 	//! ticks (ms) since the last fps calculation
 	unsigned int xdiff;
+	//! processor time used by the process at the last load report, see reportLoad()
+	clock_t cpulast;
+	//! lets loop() sleep until the next frame is due; in headless mode, until the next step
+	FramePacer pacer;
+	//! hands the state from the simulation thread to the render thread
+	SnapshotBuffer snapshots;
+	//! input waiting for the simulation thread, see pushInput()
+	std::vector<Input> input;
+	//! the input processInput() is working on, kept to not allocate again
+	std::vector<Input> pending;
+	//! guards input
+	SDL_mutex *inputlock;
+	//! times the phases of every frame
+	FrameProfiler profiler;
+	//! where dumpProfile() writes to, empty for nowhere
+	std::string profilefile;
 };
 
-//! function given to every created timer to process it
-/*! SDL needs a C function to call when the timer has finished one intervall.
-    This one runs in another thread. so it pushes an event providing the necessary data to the SDL event queue.
-    This event will be processed by loop(), inside of the Framework :)
-*/
-unsigned int processTimer(unsigned int intervall, void* data);
-
 #endif
@@ -0,0 +1,103 @@
+#include "Grid.hpp"
+#include "Field.hpp"
+#include "Player.hpp"
+#include <cmath>
+#include <algorithm>
+
+Grid::Grid()
+: size(1.0), inverse(1.0), min(0.0, 0.0, 0.0), nx(1), ny(1), nz(1), first(1, 0)
+{
+	index.push_back(0);
+}
+
+void Grid::resize(Field& field, double cell)
+{
+	size = cell;
+	inverse = 1.0 / cell;
+	// behind the paddles there is still one unit until a ball counts as outside
+	min = Vec3f(-field.getWidth()/2.0, -field.getHeight()/2.0, -field.getLength()/2.0 - 1.0);
+	nx = std::max(1, (int)ceil(field.getWidth() / size));
+	ny = std::max(1, (int)ceil(field.getHeight() / size));
+	nz = std::max(1, (int)ceil((field.getLength() + 2.0) / size));
+}
+
+int Grid::cell(double x, double y, double z)
+{
+	return (axis(z, toDouble(min.z), nz) * ny + axis(y, toDouble(min.y), ny)) * nx + axis(x, toDouble(min.x), nx);
+}
+
+void Grid::insert(const double* x, const double* y, const double* z, int count)
+{
+	cellof.resize(count);
+	index.resize(std::max(count, 1));
+	spare.resize(index.size());
+	for (int i = 0; i < count; i++)
+	{
+		cellof[i] = cell(x[i], y[i], z[i]);
+		index[i] = i;
+	}
+
+	/* a radix sort by the cells' numbers, a byte at a time starting with the lowest. Other than
+	   counting the balls of every cell, this takes the same time however many cells there are,
+	   and every cell's balls stay in the order of their numbers. */
+	for (int shift = 0; ((nx * ny * nz - 1) >> shift) > 0; shift += 8)
+	{
+		int bucket[257] = { 0 };
+		for (int k = 0; k < count; k++)
+			bucket[((cellof[index[k]] >> shift) & 255) + 1]++;
+		for (int b = 1; b < 256; b++)
+			bucket[b] += bucket[b - 1];
+		for (int k = 0; k < count; k++)
+			spare[bucket[(cellof[index[k]] >> shift) & 255]++] = index[k];
+		index.swap(spare);
+	}
+
+	// now every cell's balls follow each other, note where each cell holding balls starts
+	occupied.clear();
+	first.clear();
+	for (int k = 0; k < count; k++)
+	{
+		int c = cellof[index[k]];
+		if (occupied.empty()||(occupied.back() != c)) {
+			occupied.push_back(c);
+			first.push_back(k);
+		}
+	}
+	first.push_back(count);
+}
+
+void Grid::insert(const std::vector<Player*>& player)
+{
+	paddle.resize(std::min((int)player.size(), 32));
+
+	for (int p = 0; p < paddle.size(); p++)
+	{
+		Vec2f pos = player[p]->getPosition();
+		Vec2f extent = player[p]->getSize();
+		// from the front of the paddle to the end of the grid on its side
+		double front = toDouble(player[p]->getFront()) * (player[p]->getSide() == FRONT ? 1.0 : -1.0);
+		double back = toDouble(player[p]->getSide() == FRONT ? -min.z : min.z);
+
+		Box& box = paddle[p];
+		box.x0 = axis(toDouble(pos.x - extent.x/2.0), toDouble(min.x), nx);	box.x1 = axis(toDouble(pos.x + extent.x/2.0), toDouble(min.x), nx);
+		box.y0 = axis(toDouble(pos.y - extent.y/2.0), toDouble(min.y), ny);	box.y1 = axis(toDouble(pos.y + extent.y/2.0), toDouble(min.y), ny);
+		box.z0 = axis(std::min(front, back), toDouble(min.z), nz);	box.z1 = axis(std::max(front, back), toDouble(min.z), nz);
+	}
+}
+
+unsigned int Grid::paddles(const Vec3f& from, const Vec3f& to, double radius)
+{
+	unsigned int found = 0;
+
+	int x0 = axis(toDouble(std::min(from.x, to.x)) - radius, toDouble(min.x), nx), x1 = axis(toDouble(std::max(from.x, to.x)) + radius, toDouble(min.x), nx);
+	int y0 = axis(toDouble(std::min(from.y, to.y)) - radius, toDouble(min.y), ny), y1 = axis(toDouble(std::max(from.y, to.y)) + radius, toDouble(min.y), ny);
+	int z0 = axis(toDouble(std::min(from.z, to.z)) - radius, toDouble(min.z), nz), z1 = axis(toDouble(std::max(from.z, to.z)) + radius, toDouble(min.z), nz);
+
+	for (int p = 0; p < paddle.size(); p++)
+	{
+		const Box& box = paddle[p];
+		if ((x0 <= box.x1)&&(box.x0 <= x1)&&(y0 <= box.y1)&&(box.y0 <= y1)&&(z0 <= box.z1)&&(box.z0 <= z1))
+			found |= 1 << p;
+	}
+	return found;
+}
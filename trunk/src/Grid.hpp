@@ -0,0 +1,99 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <vector>
+#include "stuff.hpp"
+
+class Field;
+class Player;
+
+//! A uniform grid laid over the field, to find out quickly what is close to a ball
+/*! Balls are sorted into the grid's cells on every step, so a ball only needs to be tested against
+    the balls in its own and the neighbouring cells. Only the cells holding balls are noted, in the
+    order of their numbers, so the cells may be small and most of them empty.
+    Paddles are registered as the box of cells they cover.
+    Nothing gets allocated while sorting, as long as the number of balls doesn't grow.
+*/
+class Grid
+{
+public:
+	//! The constructor, creating an empty grid
+	Grid();
+
+	//! lay the grid over the field (including the space behind the paddles)
+	/*!	\param field the field to cover
+		\param size the cells' edge length, should be at least the diameter of the biggest ball
+	*/
+	void resize(Field& field, double size);
+
+	//! sort the balls into the cells, forgetting about the ones sorted in before
+	/*!	\param x the balls' X coordinates
+		\param y the balls' Y coordinates
+		\param z the balls' Z coordinates
+		\param count how many balls there are
+	*/
+	void insert(const double* x, const double* y, const double* z, int count);
+	//! register the boxes of cells the paddles cover, forgetting about the ones registered before
+	/*! only the first 32 players are taken into account
+		\param player the players with their paddles
+	*/
+	void insert(const std::vector<Player*>& player);
+
+	//! find the paddles a ball could touch
+	/*!	\param from where the ball starts
+		\param to where the ball wants to go
+		\param radius the ball's radius
+		\result bitfield of the indices of the players, whose paddle is in a cell touched on the way
+	*/
+	unsigned int paddles(const Vec3f& from, const Vec3f& to, double radius);
+
+	//! returns the cell a point lies in (points outside of the grid are taken to the nearest cell)
+	int cell(double x, double y, double z);
+	//! returns the cell at the given cell coordinates
+	inline int at(int x, int y, int z) { return (z * ny + y) * nx + x; }
+	//! returns the cell coordinates of a cell
+	inline void coordinates(int c, int& x, int& y, int& z) { int row = c / nx; x = c - row * nx; z = row / ny; y = row - z * ny; }
+	//! returns the number of cells on every axis
+	inline void getCells(int& x, int& y, int& z) { x = nx; y = ny; z = nz; }
+	//! returns how many cells hold balls
+	inline int getOccupied() { return occupied.size(); }
+	//! returns the k-th cell holding balls, counting in the order of the cells' numbers
+	inline int getOccupied(int k) { return occupied[k]; }
+	//! returns the first of the ball indices in the k-th cell holding balls
+	inline const int* begin(int k) { return &index[0] + first[k]; }
+	//! returns the end of the ball indices in the k-th cell holding balls
+	inline const int* end(int k) { return &index[0] + first[k + 1]; }
+private:
+	//! returns the cell coordinate on one axis
+	inline int axis(double v, double min, int n)
+	{
+		int i = (int)((v - min) * inverse);
+		return (i < 0 ? 0 : (i >= n ? n - 1 : i));
+	}
+
+	//! edge length of a cell, and one by it
+	double size, inverse;
+	//! lower corner of the grid
+	Vec3f min;
+	//! number of cells on every axis
+	int nx, ny, nz;
+
+	//! ball indices, sorted by cell
+	std::vector<int> index;
+	//! room for the ball indices while sorting
+	std::vector<int> spare;
+	//! cell of every ball
+	std::vector<int> cellof;
+	//! the cells holding balls, in the order of their numbers
+	std::vector<int> occupied;
+	//! where the ball indices of every cell in occupied start in index, plus the overall end
+	std::vector<int> first;
+	//! the cells a paddle covers, from the lowest to the highest cell coordinates
+	struct Box {
+		int x0, y0, z0, x1, y1, z1;
+	};
+	//! the box of every player's paddle
+	std::vector<Box> paddle;
+};
+
+#endif
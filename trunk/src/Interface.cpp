@@ -4,11 +4,15 @@
 #include <cmath>
 #include "Interface.hpp"
 #include "Framework.hpp"
-#include "Player.hpp"
+#include "Snapshot.hpp"
+#include "FrameProfiler.hpp"
 
 Interface::Interface(Framework* control)
- : fontlist(-1), framework(control), ping(""), fps("0 FPS"), roundnum("Round 1"), paused(false), flashtimer(-1)
+ : fontlist(-1), framework(control), fps("0 FPS"), showprofile(false)
 {
+	// a dedicated server has neither textures nor a font to render
+	if (framework->isHeadless()) return;
+
 	backTexture = framework->loadTexture("background.png");
 	charTexture[0] = framework->loadTexture("q1.png");
 	charTexture[1] = framework->loadTexture("q2.png");
@@ -32,65 +36,72 @@ void Interface::updateRound(int r)
 {
 	std::stringstream roundstr;
 	roundstr << "Round " << r+1;
-	roundnum = roundstr.str();
+	hud.roundnum = roundstr.str();
 }
 
 void Interface::updatePing(double pingtime)
 {
 	std::stringstream pingstr;
 	pingstr << round(pingtime * 10.0)/10.0 << " ms";
-	ping = pingstr.str();
+	hud.ping = pingstr.str();
 }
 
-void Interface::updateFPS(double frames)
+void Interface::updateFPS(double frames, double oversleep)
 {
 	std::stringstream fpsstr;
 	fpsstr << round(frames * 10.0)/10.0 << " FPS";
+	if (oversleep > 0.0)
+		fpsstr << ", " << round(oversleep * 10.0)/10.0 << " ms overslept";
 	fps = fpsstr.str();
 }
 
+void Interface::updateProfile(FrameProfiler& profiler)
+{
+	profile.clear();
+	profile.push_back("phase");
+	profile.push_back("p50");
+	profile.push_back("p99");
+	profile.push_back("max us");
+	for (int p = 0; p < FrameProfiler::PHASES; p++)
+	{
+		unsigned int stat[3];
+		profiler.getStats((FrameProfiler::Phase)p, stat[0], stat[1], stat[2]);
+
+		profile.push_back(FrameProfiler::getName((FrameProfiler::Phase)p));
+		for (int i = 0; i < 3; i++)
+		{
+			std::stringstream cell;
+			cell << stat[i];
+			profile.push_back(cell.str());
+		}
+	}
+}
+
 void Interface::updateScore(Side side, int points)
 {
 	int idx = (side == FRONT ? 0 : 1);
 	std::stringstream pts;
 	pts << points;
-	score[idx] = pts.str();
+	hud.score[idx] = pts.str();
 }
 
 void Interface::addMessage(Message msg)
 {
-	message.push_back(msg);
+	hud.message.push_back(msg);
 	if ((msg == FLASH_GAME_STARTED)||(msg == FLASH_YOU_LOST)||(msg == FLASH_YOU_WIN))
 	{
-		if (flashtimer != -1) {
-			message.remove(FLASH_GAME_STARTED);
-			message.remove(FLASH_YOU_LOST);
-			message.remove(FLASH_YOU_WIN);
-			framework->removeTimer(flashtimer);
-		}
-		flashalpha = 1.0;
-		flashtimer = framework->addTimer(25, DEFLASH, this);
+		// only one at a time, the new one starts over
+		hud.message.remove(FLASH_GAME_STARTED);
+		hud.message.remove(FLASH_YOU_LOST);
+		hud.message.remove(FLASH_YOU_WIN);
+		hud.message.push_back(msg);
+		hud.flashstart = framework->getTime();
 	}
 }
 
 void Interface::removeMessage(Message msg)
 {
-	message.remove(msg);
-}
-
-void Interface::action(Event event)
-{
-	if (event == DEFLASH) {
-		if (flashalpha > 0.05)
-			flashalpha -= 0.01 + flashalpha*0.02;
-		else {
-			message.remove(FLASH_GAME_STARTED);
-			message.remove(FLASH_YOU_LOST);
-			message.remove(FLASH_YOU_WIN);
-			framework->removeTimer(flashtimer);
-			flashtimer = -1;
-		}
-	}
+	hud.message.remove(msg);
 }
 
 void Interface::createFont()
@@ -288,20 +299,20 @@ void Interface::drawBackground(bool cruel)
 	endDraw();
 }
 
-void Interface::drawRound()
+void Interface::drawRound(const Hud& shown)
 {
 	beginDraw();
 
 	glColor3f(1.0, 1.0, 1.0);
 
-	glTranslatef(200.0 - textWidth(roundnum)/2.0 * 2.0, 300.0 - 2.0, 0);
+	glTranslatef(200.0 - textWidth(shown.roundnum)/2.0 * 2.0, 300.0 - 2.0, 0);
 	glScalef(2.0, 2.0, 2.0);
-	drawText(roundnum);
+	drawText(shown.roundnum);
 
 	endDraw();
 }
 
-void Interface::drawFPS()
+void Interface::drawFPS(const Hud& shown)
 {
 	beginDraw();
 	glEnable(GL_BLEND);
@@ -316,15 +327,39 @@ void Interface::drawFPS()
 
 	glLoadIdentity();
 	glTranslatef(2.0, 20.0, 0);
-	drawText(ping);
+	drawText(shown.ping);
 
 	glDisable(GL_BLEND);
 	endDraw();
 }
 
-void Interface::drawScore()
+void Interface::drawProfile()
+{
+	if (!showprofile) return;
+
+	// where the columns start: name, p50, p99, max
+	static const double column[4] = { 2.0, 70.0, 100.0, 130.0 };
+	int rows = profile.size() / 4;
+
+	beginDraw();
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_COLOR, GL_ONE);
+	glColor4f(1.0, 1.0, 0.5, 0.75f);
+
+	// above the FPS and ping, the header on top
+	for (int i = 0; i < profile.size(); i++)
+	{
+		glLoadIdentity();
+		glTranslatef(column[i % 4], 40.0 + (rows - 1 - i / 4) * 10.0, 0);
+		drawText(profile[i]);
+	}
+
+	glDisable(GL_BLEND);
+	endDraw();
+}
+
+void Interface::drawScore(const Hud& shown, const std::vector<PaddleSnapshot>& paddle)
 {
-	const std::vector<Player*>& player = framework->getPlayers();
 	beginDraw();
 
 	for(int i = 0; i < 2; i++)
@@ -335,11 +370,11 @@ void Interface::drawScore()
 			glColor3f(1.0, 0.5, 0.5);
 		}
 		int namecount = 0;
-		for (int j = 0; j < player.size(); ++j)
+		for (int j = 0; j < paddle.size(); ++j)
 		{
-			if (player[j]->getSide() == (i == 0 ? FRONT : BACK))
+			if (paddle[j].side == (i == 0 ? FRONT : BACK))
 			{
-				const char* name = player[j]->getName().c_str();
+				const char* name = paddle[j].name.c_str();
 				glLoadIdentity();
 				if (i == 0) {
 					glTranslatef(2.0, 0, 0);
@@ -357,22 +392,29 @@ void Interface::drawScore()
 		if (i == 0) {
 			glTranslatef(2.0, 0, 0);
 		} else {
-			glTranslatef(400.0 - textWidth(score[i])*5.0 - 2.0, 0, 0);
+			glTranslatef(400.0 - textWidth(shown.score[i])*5.0 - 2.0, 0, 0);
 		}
 		glTranslatef(0, 300.0 - 2.0 - 18.0 * namecount, 0);
 		glScalef(5.0, 5.0, 5.0);
-		drawText(score[i]);
+		drawText(shown.score[i]);
 	}
 
 	endDraw();
 }
 
-void Interface::drawMessages()
+void Interface::drawMessages(const Hud& shown, unsigned int time)
 {
+	/* a flashing message fades out as it did when it lost 0.01 + 2% of its alpha every
+	   25 ms: from 1.0 to gone at 0.05 in about 1.25 s; it stays in the list until the next one */
+	double flashalpha = 1.5 * pow(0.98, (time - shown.flashstart) / 25.0) - 0.5;
+	bool flashing = (flashalpha > 0.05);
+
 	beginDraw();
 
-	for (std::list<Message>::iterator it = message.begin(); it != message.end(); it++)
+	for (std::list<Message>::const_iterator it = shown.message.begin(); it != shown.message.end(); it++)
 	{
+		if (!flashing && ((*it == FLASH_GAME_STARTED)||(*it == FLASH_YOU_LOST)||(*it == FLASH_YOU_WIN)))
+			continue;
 		switch (*it)
 		{
 		case YOU_SERVE:
@@ -444,7 +486,7 @@ void Interface::drawMessages()
 		}
 		glLoadIdentity();
 	}
-	if (paused) {
+	if (shown.paused) {
 			glColor4f(1.0, 1.0, 1.0, 1.0);
 			glTranslatef(200.0 - textWidth("* PAUSED *")/2.0 * 8.0, 150.0 + 4.0 * 8.0, 0);
 			glScalef(8.0, 8.0, 8.0);
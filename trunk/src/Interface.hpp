@@ -8,12 +8,14 @@
 #include <set>
 
 class Framework;
+class FrameProfiler;
+struct PaddleSnapshot;
 
 //! mainly responsible for text output (HUD)
 /*! This class is to provide a user interface, mainly a HUD. It shows some stuff, like a
     background picture and text messages with some effects. It builds up it's own textured
     bitmap font for that. */
-class Interface : public EventReceiver {
+class Interface {
 
 public:
 	//! unique shown messages
@@ -32,6 +34,25 @@ public:
 		FLASH_YOU_WIN
 	};
 
+	//! what the HUD shows of the game, changed by the simulation and drawn from a Snapshot
+	struct Hud {
+		//! constructor setting up an empty HUD
+		inline Hud() : flashstart(0), paused(false), roundnum("Round 1"), ping("") {}
+		//! when the flashing message was added (simulation time, ticks)
+		/*! Its alpha value is worked out from it when drawing, no timer needed. */
+		unsigned int flashstart;
+		//! wether or not we're paused
+		bool paused;
+		//! actual round string
+		std::string roundnum;
+		//! actual ping string
+		std::string ping;
+		//! scores to be shown
+		std::string score[2];
+		//! list of active messages
+		std::list<Message> message;
+	};
+
 	//! The constructor
 	/*!	\param control the game's Framework (ie Server or Client) object
 	*/
@@ -39,7 +60,9 @@ public:
 	//! The destructor
 	~Interface();
 	//! toggle wether the "PAUSED" message is shown
-	inline void togglePaused(bool p) { paused = p; };
+	inline void togglePaused(bool p) { hud.paused = p; };
+	//! returns what the HUD shows, to be put into a Snapshot
+	inline const Hud& getHud() { return hud; }
 	//! update the shown round number
 	/*! \param r the actual game round
 	*/
@@ -48,10 +71,19 @@ public:
 	/*! \param ping latest ping measurement
 	*/
 	void updatePing(double ping);
-	//! update the shown fps
+	//! update the shown fps; unlike the other updates, called by the render thread
 	/*! \param frames recently achieved Frames Per Second
+		\param oversleep how late the FramePacer woke up for a frame, on average (ms); shown if not 0
+	*/
+	void updateFPS(double frames, double oversleep);
+	//! toggle wether the frame profile is shown, called by the render thread
+	inline void toggleProfile() { showprofile = !showprofile; }
+	//! returns wether the frame profile is shown
+	inline bool isProfileShown() { return showprofile; }
+	//! update the shown frame profile, called by the render thread
+	/*! \param profiler the profiler to show the phases' timings of
 	*/
-	void updateFPS(double frames);
+	void updateProfile(FrameProfiler& profiler);
 
 	void updateScore(Side side, int points);
 
@@ -62,24 +94,31 @@ public:
 	/*! \param msg the Message type */
 	void removeMessage(Message msg);
 
-	//! process a timer triggered event
-	/*!	\param event the event descriptor
-	*/
-	void action(Event event);
-
 	//! draw the background
 	/*! \param cruel wether or not to use cruel stuff to make it look nice for PAUSED mode
 	*/
 	void drawBackground(bool cruel);
 	//! draw the FPS counter and ping time onto the screen
-	void drawFPS();
+	/*! \param shown the HUD to draw
+	*/
+	void drawFPS(const Hud& shown);
 	//! draw the round number onto the screen
-	void drawRound();
+	/*! \param shown the HUD to draw
+	*/
+	void drawRound(const Hud& shown);
 	//! draw the player scores onto the screen
-	void drawScore();
+	/*! \param shown the HUD to draw
+		\param paddle the paddles, for the player names
+	*/
+	void drawScore(const Hud& shown, const std::vector<PaddleSnapshot>& paddle);
 	//! draw every active Message onto the screen
-	/*! Also draws the PAUSED string if paused. */
-	void drawMessages();
+	/*! Also draws the PAUSED string if paused.
+		\param shown the HUD to draw
+		\param time the simulation time drawn (ticks), for fading the flashing messages
+	*/
+	void drawMessages(const Hud& shown, unsigned int time);
+	//! draw the frame profile onto the screen, if it is shown
+	void drawProfile();
 private:
 	//! a single character in our font
 	struct Char {
@@ -112,23 +151,14 @@ private:
 	GLuint charTexture[5];
 	//! descriptor for the texture used in the background
 	GLuint backTexture;
-	//! descriptor for the timer used for flashing of messages
-	int flashtimer;
-	//! actual alpha value of a flashing message
-	double flashalpha;
-
-	//! wether or not we're paused
-	bool paused;
-	//! actual round string
-	std::string roundnum;
-	//! actual ping string
-	std::string ping;
-	//! actual fps string
+	//! the HUD's state, only changed by the simulation
+	Hud hud;
+	//! actual fps string, only changed by the render thread
 	std::string fps;
-	//! scores to be shown
-	std::string score[2];
-	//! list of active messages
-	std::list<Message> message;
+	//! wether the frame profile is shown
+	bool showprofile;
+	//! the cells of the frame profile, four per line, only changed by the render thread
+	std::vector<std::string> profile;
 };
 
 #endif
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <algorithm>
+#include "Match.hpp"
+
+Match::Match(const Configuration& conf, double error)
+ : Framework(NULL, conf, UNINITIALIZED), scored(false), serving(FRONT),
+   rallies(0), hits(0), steps(0), hash(2166136261u), seed(42)
+{
+	score[0] = score[1] = 0;
+	ball.push_back(Ball(this));
+	player.push_back(new Player(this, "Mr. Wand", FRONT, field.getLength()/2.0));
+	player.push_back(new Player(this, "Mr. Wand", BACK, field.getLength()/2.0));
+	bot.push_back(Bot(player[0], error, 1));
+	bot.push_back(Bot(player[1], error, 2));
+	serveBall();
+}
+
+Match::~Match()
+{
+	for (int i = 0; i < player.size(); i++)
+		delete player[i];
+}
+
+void Match::play(unsigned long count)
+{
+	unsigned long end = rallies + count;
+	while (rallies < end)
+	{
+		// no waiting: the clock just says the next step is due
+		tick(getTime() + getTimestep());
+		steps++;
+		if (scored) {
+			rallies++;
+			serveBall();
+		}
+	}
+}
+
+void Match::updateGame(int ticks)
+{
+	for (int i = 0; i < bot.size(); i++)
+		bot[i].update(ball[0], field, getTime());
+
+	// walls don't turn the ball around, only paddles do
+	bool towards = (ball[0].getSpeed().z > 0.0);
+	ball[0].move(ticks);
+	if (!scored && (towards != (ball[0].getSpeed().z > 0.0))) {
+		hits++;
+		note();
+	}
+}
+
+void Match::doScore(Side side)
+{
+	// called on every step until the ball is served again
+	if (scored) return;
+	scored = true;
+	score[side == BACK ? 0 : 1]++;
+	note();
+}
+
+void Match::serveBall()
+{
+	seed = seed * 1103515245u + 12345u;
+	double x = ((seed >> 16) & 0x7fff) / 16383.5 - 1.0;
+	seed = seed * 1103515245u + 12345u;
+	double y = ((seed >> 16) & 0x7fff) / 16383.5 - 1.0;
+
+	serving = (serving == FRONT ? BACK : FRONT);
+	ball[0].setPosition(Vec3f(0.0, 0.0, 0.0));
+	ball[0].setSpeed(Vec3f(x * 2.0, y * 2.0, (serving == FRONT ? 6.0 : -6.0)));
+	scored = false;
+}
+
+void Match::note()
+{
+	const Vec3f& p = ball[0].getPosition();
+	const Vec3f& s = ball[0].getSpeed();
+	Scalar value[6] = { p.x, p.y, p.z, s.x, s.y, s.z };
+
+	// byte by byte starting with the lowest, so the byte order of the machine doesn't matter
+	for (int i = 0; i < 6; i++)
+	{
+		uint64_t bits = toBits(value[i]);
+		for (int b = 0; b < 64; b += 8)
+			hash = (hash ^ (unsigned int)((bits >> b) & 0xff)) * 16777619u;
+	}
+}
+
+void Match::report(unsigned int elapsed)
+{
+	double minutes = std::max(elapsed, 1u) / 60000.0;
+	std::cout << rallies << " rallies, " << hits << " hits (" << (double)hits / std::max(rallies, 1ul) << " per rally), "
+		<< "points " << score[0] << ":" << score[1] << std::endl;
+	std::cout << steps << " steps (" << steps * getTimestep() / 1000 << " s of play) in " << elapsed << " ms, "
+		<< rallies / minutes << " rallies per minute, hash " << std::hex << hash << std::dec << std::endl;
+}
@@ -0,0 +1,74 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "Framework.hpp"
+#include "Bot.hpp"
+
+//! Mr. Wand against Mr. Wand, as fast as the processor can
+/*! There is no window, no network and no waiting: one simulation step follows the other right away,
+    and every rally is served again as soon as it is over. Used by 'pong2 -r' to check the physics
+    and to load a machine, and by pong2-bench.
+    Both Mr. Wands miss their target by a random error, or the rallies would never end. The random
+    numbers are the same on every machine, so with fixed point (see Fixed.hpp) the hash of a match is too.
+*/
+class Match : public Framework
+{
+public:
+	//! The constructor, setting up two paddles of the usual size
+	/*!	\param conf a Configuration asking for headless operation
+		\param error how far the Mr. Wands miss their target at most (units)
+	*/
+	Match(const Configuration& conf, double error);
+	//! The destructor, deleting the players
+	~Match();
+
+	//! play until count more rallies are over
+	/*!	\param count how many rallies to play
+	*/
+	void play(unsigned long count);
+
+	//! print what happened, like the load of a dedicated server
+	/*!	\param elapsed wall clock time the rallies took (ms)
+	*/
+	void report(unsigned int elapsed);
+
+	//! returns how many rallies are over
+	inline unsigned long getRallies() { return rallies; }
+	//! returns how often a paddle hit the ball
+	inline unsigned long getHits() { return hits; }
+	//! returns how many simulation steps were done
+	inline unsigned long getSteps() { return steps; }
+	//! returns a hash of every hit and score, to compare matches
+	inline unsigned int getHash() { return hash; }
+private:
+	void movePaddle(double x, double y, unsigned int time) {}
+	//! let the Mr. Wands move and the ball fly for one step
+	void updateGame(int ticks);
+	//! note the score, the next rally is served by play()
+	void doScore(Side side);
+	//! kick the ball off from the middle, to the other side than the last time
+	void serveBall();
+	void ping() {}
+	void doNetworking() {}
+	void sendPacket(Buffer& data, bool reliable) {}
+
+	//! add the ball's position and speed to the hash
+	void note();
+
+	//! the two Mr. Wands
+	std::vector<Bot> bot;
+	//! wether the ball is out and the rally is over
+	bool scored;
+	//! the side the last serve went to
+	Side serving;
+
+	unsigned long rallies, hits, steps;
+	//! points of FRONT and BACK
+	unsigned long score[2];
+	//! FNV-1a hash of all hits and scores
+	unsigned int hash;
+	//! state of the random numbers for serving
+	unsigned int seed;
+};
+
+#endif
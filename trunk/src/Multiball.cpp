@@ -0,0 +1,410 @@
+#include "Multiball.hpp"
+#include "Field.hpp"
+#include "Player.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* The vector code is written once against these wrappers, which map it either
+   to 4 doubles at a time (AVX) or to 2 doubles at a time (SSE2). */
+#if defined(__AVX__)
+struct Lanes {
+	typedef __m256d V;
+	enum { width = 4 };
+	static inline V load(const double* p) { return _mm256_loadu_pd(p); }
+	static inline void store(double* p, V a) { _mm256_storeu_pd(p, a); }
+	static inline V set(double a) { return _mm256_set1_pd(a); }
+	static inline V add(V a, V b) { return _mm256_add_pd(a, b); }
+	static inline V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+	static inline V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+	static inline V greater(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	static inline V both(V a, V b) { return _mm256_and_pd(a, b); }
+	static inline V flip(V a, V b) { return _mm256_xor_pd(a, b); }
+	static inline V select(V mask, V a, V b) { return _mm256_blendv_pd(b, a, mask); }
+	static inline int bits(V mask) { return _mm256_movemask_pd(mask); }
+};
+#elif defined(__SSE2__)
+struct Lanes {
+	typedef __m128d V;
+	enum { width = 2 };
+	static inline V load(const double* p) { return _mm_loadu_pd(p); }
+	static inline void store(double* p, V a) { _mm_storeu_pd(p, a); }
+	static inline V set(double a) { return _mm_set1_pd(a); }
+	static inline V add(V a, V b) { return _mm_add_pd(a, b); }
+	static inline V sub(V a, V b) { return _mm_sub_pd(a, b); }
+	static inline V mul(V a, V b) { return _mm_mul_pd(a, b); }
+	static inline V greater(V a, V b) { return _mm_cmpgt_pd(a, b); }
+	static inline V both(V a, V b) { return _mm_and_pd(a, b); }
+	static inline V flip(V a, V b) { return _mm_xor_pd(a, b); }
+	static inline V select(V mask, V a, V b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+	static inline int bits(V mask) { return _mm_movemask_pd(mask); }
+};
+#endif
+
+Multiball::Multiball()
+: pairs(0), quad(NULL), displist(-1)
+{
+}
+
+Multiball::~Multiball()
+{
+	if (quad != NULL) gluDeleteQuadric(quad);
+	if (displist != -1) glDeleteLists(displist, 1);
+}
+
+int Multiball::add(const Vec3f& pos, const Vec3f& spd, double r)
+{
+	x.push_back(toDouble(pos.x));	y.push_back(toDouble(pos.y));	z.push_back(toDouble(pos.z));
+	vx.push_back(toDouble(spd.x));	vy.push_back(toDouble(spd.y));	vz.push_back(toDouble(spd.z));
+	radius.push_back(r);
+	scale.push_back(1.0);
+	return x.size() - 1;
+}
+
+void Multiball::spawn(int count, Field& field, double speed)
+{
+	const double r = 0.1;
+	for (int i = 0; i < count; i++)
+	{
+		// somewhere in the middle third of the field, so nobody gets hit right away
+		Vec3f pos((rand() / (double)RAND_MAX - 0.5) * (field.getWidth() - 2.0 * r),
+			(rand() / (double)RAND_MAX - 0.5) * (field.getHeight() - 2.0 * r),
+			(rand() / (double)RAND_MAX - 0.5) * field.getLength() / 3.0);
+		Vec3f spd((rand() / (double)RAND_MAX - 0.5) * speed,
+			(rand() / (double)RAND_MAX - 0.5) * speed,
+			(rand() % 2 ? speed : -speed));
+		add(pos, spd, r);
+	}
+	close.reserve(x.size());
+
+	// the cells just hold the biggest ball: the fewest pairs to test, and empty cells cost nothing
+	double edge = 0.0;
+	for (int i = 0; i < x.size(); i++)
+		edge = std::max(edge, 2.0 * radius[i]);
+	if (edge > 0.0) grid.resize(field, edge);
+}
+
+void Multiball::clear()
+{
+	x.clear();	y.clear();	z.clear();
+	lastx.clear();	lasty.clear();	lastz.clear();
+	vx.clear();	vy.clear();	vz.clear();
+	radius.clear();
+	scale.clear();
+}
+
+const char* Multiball::simd()
+{
+#if defined(__AVX__)
+	return "AVX";
+#elif defined(__SSE2__)
+	return "SSE2";
+#else
+	return "none";
+#endif
+}
+
+void Multiball::move(int ticks, Field& field, const std::vector<Player*>& player)
+{
+	fly(ticks, field, player);
+	collide();
+}
+
+void Multiball::fly(int ticks, Field& field, const std::vector<Player*>& player)
+{
+	double time = ticks / 1000.0;
+	double w = field.getWidth() / 2.0, h = field.getHeight() / 2.0;
+
+	// beyond this, a ball could meet a paddle or leave the field
+	double front = field.getLength() / 2.0;
+	for (int p = 0; p < player.size(); p++)
+		front = std::min(front, toDouble(player[p]->getFront()));
+
+	// the positions before are kept by swapping, the new ones are written over the older ones
+	if (lastx.size() != x.size()) {
+		lastx = x;	lasty = y;	lastz = z;
+	}
+	lastx.swap(x);	lasty.swap(y);	lastz.swap(z);
+	grid.insert(player);
+	close.clear();
+	int n = x.size();
+	int i = 0;
+
+#if defined(__AVX__) || defined(__SSE2__)
+	const Lanes::V t = Lanes::set(time);
+	const Lanes::V sign = Lanes::set(-0.0), zero = Lanes::set(0.0);
+	const Lanes::V halfw = Lanes::set(w), halfh = Lanes::set(h), limz = Lanes::set(front);
+
+	for (; i + Lanes::width <= n; i += Lanes::width)
+	{
+		Lanes::V r = Lanes::load(&radius[i]);
+		Lanes::V ox = Lanes::load(&lastx[i]), oy = Lanes::load(&lasty[i]), oz = Lanes::load(&lastz[i]);
+		Lanes::V osx = Lanes::load(&vx[i]), osy = Lanes::load(&vy[i]), sz = Lanes::load(&vz[i]);
+
+		Lanes::V px = Lanes::add(ox, Lanes::mul(osx, t));
+		Lanes::V py = Lanes::add(oy, Lanes::mul(osy, t));
+		Lanes::V pz = Lanes::add(oz, Lanes::mul(sz, t));
+
+		// reflect at LEFT / RIGHT: mirror the part beyond the wall back into the field
+		Lanes::V lim = Lanes::sub(halfw, r);
+		Lanes::V mirror = Lanes::sub(Lanes::flip(Lanes::add(lim, lim), Lanes::both(px, sign)), px);
+		Lanes::V out = Lanes::greater(Lanes::flip(px, Lanes::both(px, sign)), lim);
+		px = Lanes::select(out, mirror, px);
+		Lanes::V sx = Lanes::flip(osx, Lanes::both(out, sign));
+
+		// reflect at TOP / BOTTOM
+		lim = Lanes::sub(halfh, r);
+		mirror = Lanes::sub(Lanes::flip(Lanes::add(lim, lim), Lanes::both(py, sign)), py);
+		out = Lanes::greater(Lanes::flip(py, Lanes::both(py, sign)), lim);
+		py = Lanes::select(out, mirror, py);
+		Lanes::V sy = Lanes::flip(osy, Lanes::both(out, sign));
+
+		// balls near the paddles, and on their way towards them, are left as they are and handled
+		// one by one afterwards
+		Lanes::V near = Lanes::both(Lanes::greater(Lanes::add(Lanes::flip(pz, Lanes::both(pz, sign)), r), limz),
+			Lanes::greater(Lanes::mul(pz, sz), zero));
+		int mask = Lanes::bits(near);
+
+		Lanes::store(&x[i], Lanes::select(near, ox, px));
+		Lanes::store(&y[i], Lanes::select(near, oy, py));
+		Lanes::store(&z[i], Lanes::select(near, oz, pz));
+		Lanes::store(&vx[i], Lanes::select(near, osx, sx));
+		Lanes::store(&vy[i], Lanes::select(near, osy, sy));
+
+		for (int l = 0; mask != 0; l++, mask >>= 1)
+			if (mask & 1) close.push_back(i + l);
+	}
+#endif
+
+	// whatever doesn't fill the vector registers, one by one
+	for (; i < n; i++)
+	{
+		double pz = lastz[i] + vz[i] * time;
+		if ((fabs(pz) + radius[i] > front)&&(pz * vz[i] > 0.0)) {
+			x[i] = lastx[i];	y[i] = lasty[i];	z[i] = lastz[i];
+			close.push_back(i);
+			continue;
+		}
+		z[i] = pz;
+
+		double px = lastx[i] + vx[i] * time, lim = w - radius[i];
+		if (fabs(px) > lim) {
+			px = (px < 0 ? -2.0 * lim : 2.0 * lim) - px;
+			vx[i] = -vx[i];
+		}
+		x[i] = px;
+
+		double py = lasty[i] + vy[i] * time;
+		lim = h - radius[i];
+		if (fabs(py) > lim) {
+			py = (py < 0 ? -2.0 * lim : 2.0 * lim) - py;
+			vy[i] = -vy[i];
+		}
+		y[i] = py;
+	}
+
+	for (int c = 0; c < close.size(); c++)
+		moveSingle(close[c], time, field, player);
+}
+
+void Multiball::moveSingle(int i, double time, Field& field, const std::vector<Player*>& player)
+{
+	Vec3f position(x[i], y[i], z[i]);
+	Vec3f speed(vx[i], vy[i], vz[i]);
+	Scalar r = radius[i];
+	Scalar left = time;
+	Collision collide;
+
+	for (int bounces = 0; (left > 0.0) && (bounces < 4); bounces++)
+	{
+		Scalar impact = left;
+		bool hit = field.detectCol(position, speed, r, impact, collide);
+
+		// only the paddles in the cells on the way are worth a closer look
+		Vec3f destination(position.x + speed.x * left, position.y + speed.y * left, position.z + speed.z * left);
+		unsigned int near = grid.paddles(position, destination, radius[i]);
+		for (int p = 0; p < player.size(); p++)
+			if ((p >= 32)||(near & (1 << p)))
+				hit |= player[p]->detectCol(position, speed, r, impact, collide);
+
+		if (!hit) {
+			position.x += speed.x * left;
+			position.y += speed.y * left;
+			position.z += speed.z * left;
+			break;
+		}
+
+		position = collide.position;
+		speed = collide.speed;
+		left -= impact;
+	}
+
+	// nobody scores, the ball just starts over from the center towards the other side
+	if (field.zOutside(position.z) != NONE) {
+		position = Vec3f(0.0, 0.0, 0.0);
+		speed.z = -speed.z;
+		lastx[i] = lasty[i] = lastz[i] = 0.0;
+	}
+
+	x[i] = toDouble(position.x);	y[i] = toDouble(position.y);	z[i] = toDouble(position.z);
+	vx[i] = toDouble(speed.x);	vy[i] = toDouble(speed.y);	vz[i] = toDouble(speed.z);
+}
+
+void Multiball::collide()
+{
+	int n = x.size();
+	if (n < 2) return;
+	grid.insert(&x[0], &y[0], &z[0], n);
+
+	// the rows of neighbouring cells "ahead" of a cell (Y and Z offset), the others have already
+	// looked at it
+	static const int ahead[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+
+	/* a ball can only touch the balls in its own and the neighbouring cells. Going through the
+	   cells holding balls in the order of their numbers, the neighbouring cells of every row ahead
+	   come in that order as well, so one cursor per row follows along and empty cells are never
+	   looked at. */
+	int nx, ny, nz;
+	grid.getCells(nx, ny, nz);
+	int cells = grid.getOccupied();
+	int cursor[4] = { 0, 0, 0, 0 };
+	for (int o = 0; o < cells; o++)
+	{
+		int c = grid.getOccupied(o);
+		int cx, cy, cz;
+		grid.coordinates(c, cx, cy, cz);
+		const int* first = grid.begin(o);
+		const int* last = grid.end(o);
+
+		// its own cell and the next one in the same row
+		for (const int* i = first; i != last; i++)
+			for (const int* j = i + 1; j != last; j++)
+				bounce(*i, *j);
+		if ((cx + 1 < nx)&&(o + 1 < cells)&&(grid.getOccupied(o + 1) == c + 1))
+			for (const int* i = first; i != last; i++)
+				for (const int* j = grid.begin(o + 1); j != grid.end(o + 1); j++)
+					bounce(*i, *j);
+
+		int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, nx - 1);
+		for (int a = 0; a < 4; a++)
+		{
+			int oy = cy + ahead[a][0], oz = cz + ahead[a][1];
+			if ((oy < 0)||(oy >= ny)||(oz >= nz))
+				continue;
+			int from = grid.at(x0, oy, oz), to = grid.at(x1, oy, oz);
+			int& k = cursor[a];
+			while ((k < cells)&&(grid.getOccupied(k) < from))
+				k++;
+			int l = k;
+			while ((l < cells)&&(grid.getOccupied(l) <= to))
+				l++;
+
+			// the balls of these cells follow each other
+			for (const int* i = first; i != last; i++)
+				for (const int* j = grid.begin(k); j != grid.begin(l); j++)
+					bounce(*i, *j);
+		}
+	}
+}
+
+void Multiball::bounce(int i, int j)
+{
+	pairs++;
+	double dx = x[j] - x[i], dy = y[j] - y[i], dz = z[j] - z[i];
+	double dist = dx*dx + dy*dy + dz*dz;
+	double reach = radius[i] + radius[j];
+	if ((dist >= reach*reach)||(dist == 0.0))
+		return;
+
+	dist = sqrt(dist);
+	dx /= dist;	dy /= dist;	dz /= dist;
+
+	// the balls' masses grow with their volume
+	double mi = radius[i]*radius[i]*radius[i], mj = radius[j]*radius[j]*radius[j];
+
+	// push them apart, the lighter one more than the heavier one
+	double overlap = (reach - dist) / (mi + mj);
+	x[i] -= dx * overlap * mj;	y[i] -= dy * overlap * mj;	z[i] -= dz * overlap * mj;
+	x[j] += dx * overlap * mi;	y[j] += dy * overlap * mi;	z[j] += dz * overlap * mi;
+
+	// they may already fly apart after an earlier bounce
+	double approach = (vx[j] - vx[i]) * dx + (vy[j] - vy[i]) * dy + (vz[j] - vz[i]) * dz;
+	if (approach >= 0.0)
+		return;
+
+	// elastic impact along the line between both centers
+	double impulse = 2.0 * approach / (mi + mj);
+	vx[i] += impulse * mj * dx;	vy[i] += impulse * mj * dy;	vz[i] += impulse * mj * dz;
+	vx[j] -= impulse * mi * dx;	vy[j] -= impulse * mi * dy;	vz[j] -= impulse * mi * dz;
+}
+
+void Multiball::takeSnapshot(SwarmSnapshot& shot)
+{
+	// balls added since the last move() have no position before
+	bool moved = (lastx.size() == x.size());
+	shot.fromx = (moved ? lastx : x);
+	shot.fromy = (moved ? lasty : y);
+	shot.fromz = (moved ? lastz : z);
+	shot.x = x;
+	shot.y = y;
+	shot.z = z;
+	shot.size.resize(x.size());
+	for (int i = 0; i < x.size(); i++)
+		shot.size[i] = radius[i] * scale[i];
+}
+
+void Multiball::draw(const SwarmSnapshot& shot, double alpha)
+{
+	if (displist == -1)
+	{
+		displist = glGenLists(1);
+		glNewList(displist, GL_COMPILE);
+
+		GLfloat mat_ambient[] = {0.10305943, 0.22610818, 0.0};
+		GLfloat mat_diffuse[] = {0.41225299, 0.90440222, 0.0};
+		GLfloat mat_specular[] = {0.09559777, 0.09559777, 0.09559777};
+		GLfloat mat_emission[] = {0.0, 0.0, 0.0};
+		GLfloat mat_shininess = 0.07812619;
+		glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, mat_ambient);
+		glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mat_diffuse);
+		glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, mat_specular);
+		glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, mat_emission);
+		glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat_shininess);
+
+		if (quad == NULL) {
+			quad = gluNewQuadric();
+			gluQuadricNormals(quad, GLU_SMOOTH);
+		}
+		// a unit sphere, scaled to every ball's radius; there may be thousands, so keep it coarse
+		gluSphere(quad, 1.0, 12, 12);
+
+		glEndList();
+	}
+
+	// scaling would also scale our normals
+	glEnable(GL_NORMALIZE);
+	const std::vector<double>& fromx = shot.fromx;
+	const std::vector<double>& fromy = shot.fromy;
+	const std::vector<double>& fromz = shot.fromz;
+	const std::vector<double>& x = shot.x;
+	const std::vector<double>& y = shot.y;
+	const std::vector<double>& z = shot.z;
+
+	for (int i = 0; i < x.size(); i++)
+	{
+		glPushMatrix();
+		glTranslatef(fromx[i] + (x[i] - fromx[i]) * alpha,
+			fromy[i] + (y[i] - fromy[i]) * alpha,
+			fromz[i] + (z[i] - fromz[i]) * alpha);
+		glScalef(shot.size[i], shot.size[i], shot.size[i]);
+		glCallList(displist);
+		glPopMatrix();
+	}
+	glDisable(GL_NORMALIZE);
+}
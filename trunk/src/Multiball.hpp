@@ -0,0 +1,120 @@
+#ifndef MULTIBALL_H
+#define MULTIBALL_H
+
+#include <vector>
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include "stuff.hpp"
+#include "Grid.hpp"
+#include "Snapshot.hpp"
+
+class Field;
+class Player;
+
+//! A swarm of additional balls for the multiball mode
+/*! Other than Ball, which is one object per ball, the swarm is stored as one array per value.
+    This way several balls are moved and reflected off the walls at once using SSE2 or AVX.
+    Only balls getting close to a paddle are handled one by one, with the full collision detection.
+    Afterwards the balls bounce off each other; a Grid makes sure only close balls are compared.
+    These balls don't score: a ball getting out of the field starts over from the center.
+*/
+class Multiball
+{
+public:
+	//! The constructor, creating an empty swarm
+	Multiball();
+	//! The destructor
+	~Multiball();
+
+	//! add a ball to the swarm
+	/*!	\param pos the ball's position
+		\param spd the ball's speed vector (units per second)
+		\param r the ball's radius
+		\result the index of the new ball
+	*/
+	int add(const Vec3f& pos, const Vec3f& spd, double r);
+	//! add balls spread over the field, flying into random directions
+	/*!	\param count how many balls to add
+		\param field the field to put the balls into
+		\param speed the balls' Z axis speed
+	*/
+	void spawn(int count, Field& field, double speed);
+	//! remove all balls
+	void clear();
+
+	//! returns how many balls there are
+	inline int size() { return x.size(); }
+	//! returns a ball's position
+	inline Vec3f getPosition(int i) { return Vec3f(x[i], y[i], z[i]); }
+	//! returns a ball's speed vector
+	inline Vec3f getSpeed(int i) { return Vec3f(vx[i], vy[i], vz[i]); }
+	//! returns a ball's radius
+	inline double getRadius(int i) { return radius[i]; }
+	//! returns how many pairs of balls got tested for touching each other so far
+	inline unsigned long getPairTests() { return pairs; }
+
+	//! move all balls on, then let them bounce off each other
+	/*!	\param ticks the time evolved in ms
+		\param field the field, its walls reflect the balls
+		\param player the players, their paddles reflect the balls
+	*/
+	void move(int ticks, Field& field, const std::vector<Player*>& player);
+	//! move all balls on, without them bouncing off each other
+	/*!	\param ticks the time evolved in ms
+		\param field the field, its walls reflect the balls
+		\param player the players, their paddles reflect the balls
+	*/
+	void fly(int ticks, Field& field, const std::vector<Player*>& player);
+	//! let all touching balls bounce off each other
+	void collide();
+	//! note what is to be drawn of the balls
+	/*!	\param shot the snapshot to fill
+	*/
+	void takeSnapshot(SwarmSnapshot& shot);
+	//! draw the balls using GL functions, called by the render thread
+	/*! Only the display list is used here, so the simulation may go on meanwhile.
+		\param shot the balls as noted by takeSnapshot()
+		\param alpha where to draw between the positions before the last move() (0) and the actual ones (1)
+	*/
+	void draw(const SwarmSnapshot& shot, double alpha);
+
+	//! the name of the instruction set used to move the balls
+	static const char* simd();
+private:
+	//! move a single ball with full collision detection, like Ball::move() does
+	/*!	\param i the ball's index
+		\param time the time to fly (seconds)
+		\param field the field, its walls reflect the ball
+		\param player the players, their paddles reflect the ball
+	*/
+	void moveSingle(int i, double time, Field& field, const std::vector<Player*>& player);
+	//! let two balls bounce off each other, if they touch and approach each other
+	/*!	\param i the first ball's index
+		\param j the second ball's index
+	*/
+	void bounce(int i, int j);
+
+	//! position of every ball
+	std::vector<double> x, y, z;
+	//! position of every ball before the last move()
+	std::vector<double> lastx, lasty, lastz;
+	//! speed values of every ball
+	std::vector<double> vx, vy, vz;
+	//! radius of every ball
+	std::vector<double> radius;
+	//! actual scaling of every ball
+	std::vector<double> scale;
+	//! indices of the balls close to a paddle, collected while moving
+	std::vector<int> close;
+	//! the balls and paddles, sorted by where they are
+	Grid grid;
+	//! number of tested pairs of balls
+	unsigned long pairs;
+
+	//! pointer to our quadrik which builds the sphere
+	GLUquadricObj *quad;
+	//! descriptor of the utilized display list
+	int displist;
+};
+
+#endif
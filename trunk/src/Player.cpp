@@ -5,31 +5,20 @@
 #include <GL/gl.h>
 #include <cmath>
 
+int Player::displist[2] = { -1, -1 };
+Vec2f Player::listsize[2];
+
 Player::Player(Framework* control, const std::string& nick, Side where, double z)
  : framework(control), name(nick), side(where), position(0, 0, (where == FRONT ? 1.0 : -1.0) * z), width(1.0f), height(1.0f),
-	speed(0, 0), maxspeed(0.01f), thickness(0.05), deceltimer(-1), attachedBall(NULL), displist(-1), lastmove(0)
+	speed(0, 0), maxspeed(0.01f), thickness(0.05), speedtime(control->getTime()), attachedBall(NULL),
+	lastmove(control->getTime()), pastcount(0), pastnewest(0)
 {}
 
-Player::~Player()
-{
-	if (deceltimer != -1) framework->removeTimer(deceltimer);
-	if (displist != -1) glDeleteLists(displist, 1);
-}
-
-void Player::run()
-{
-	deceltimer = framework->addTimer(25, DECELERATE, this);
-}
-
 void Player::setSize(double w, double h)
 {
+	// the display list follows when it's drawn the next time
 	width = w;
 	height = h;
-	if (displist != -1)
-	{
-		glDeleteLists(displist, 1);
-		displist = -1;
-	}
 }
 
 void Player::setPosition(double x, double y)
@@ -38,39 +27,66 @@ void Player::setPosition(double x, double y)
 	position.y = y;
 }
 
+void Player::setPosition(double x, double y, unsigned int time)
+{
+	setPosition(x, y);
+	lastmove = time;
+}
+
 void Player::move(double x, double y, unsigned int time)
 {
-	double timediff = (double)(time - lastmove);
-	if (timediff < 1.0) return;
+	if (time - lastmove < 1) return;
+	Scalar timediff = Scalar(time - lastmove);
 	lastmove = time;
 
-	double speedx = std::min(maxspeed, fabs(x) / timediff) * (x > 0 ? 1 : -1);
-	double speedy = std::min(maxspeed, fabs(y) / timediff) * (y > 0 ? 1 : -1);
+	Scalar speedx = std::min(maxspeed, fabs(Scalar(x)) / timediff) * (x > 0 ? 1.0 : -1.0);
+	Scalar speedy = std::min(maxspeed, fabs(Scalar(y)) / timediff) * (y > 0 ? 1.0 : -1.0);
 
-	speed.x = std::max(fabs(speed.x), fabs(speedx)) * (speedx > 0 ? 1 : -1);
-	speed.y = std::max(fabs(speed.y), fabs(speedy)) * (speedy > 0 ? 1 : -1);
+	Vec2f slowed = slowedSpeed();
+	speed.x = std::max(fabs(slowed.x), fabs(speedx)) * (speedx > 0.0 ? 1.0 : -1.0);
+	speed.y = std::max(fabs(slowed.y), fabs(speedy)) * (speedy > 0.0 ? 1.0 : -1.0);
+	speedtime = framework->getTime();
 
-	x = speedx * timediff;
-	y = speedy * timediff;
+	Scalar dx = speedx * timediff;
+	Scalar dy = speedy * timediff;
 
-	if (x < 0)
-		position.x = framework->detectBarrier(position.x + x - width/2.0f, LEFT, side) + width/2.0f;
-	else	position.x = framework->detectBarrier(position.x + x + width/2.0f, RIGHT, side) - width/2.0f;
-	if (y < 0)
-		position.y = framework->detectBarrier(position.y + y - height/2.0f, TOP, side) + height/2.0f;
-	else	position.y = framework->detectBarrier(position.y + y + height/2.0f, BOTTOM, side) - height/2.0f;
+	if (dx < 0.0)
+		position.x = framework->detectBarrier(position.x + dx - width/2.0, LEFT, side) + width/2.0;
+	else	position.x = framework->detectBarrier(position.x + dx + width/2.0, RIGHT, side) - width/2.0;
+	if (dy < 0.0)
+		position.y = framework->detectBarrier(position.y + dy - height/2.0, TOP, side) + height/2.0;
+	else	position.y = framework->detectBarrier(position.y + dy + height/2.0, BOTTOM, side) - height/2.0;
 
 	if (attachedBall != NULL)
 		attachedBall->setPosition(Vec3f(position.x, position.y,
 					position.z + (side == FRONT? -1.0 : 1.0) * (thickness * 5.0 + attachedBall->getRadius())));
 }
 
-void Player::draw()
+void Player::takeSnapshot(PaddleSnapshot& shot)
 {
-	if (displist == -1)
+	shot.name = name;
+	shot.side = side;
+	shot.position = position;
+	shot.width = width;
+	shot.height = height;
+	shot.thickness = thickness;
+}
+
+void Player::draw(const PaddleSnapshot& shot)
+{
+	int list = (shot.side == FRONT ? 0 : 1);
+	if ((displist[list] != -1)&&((listsize[list].x != shot.width)||(listsize[list].y != shot.height)))
+	{
+		glDeleteLists(displist[list], 1);
+		displist[list] = -1;
+	}
+	if (displist[list] == -1)
 	{
-		displist = glGenLists(1);
-		glNewList(displist, GL_COMPILE);
+		Side side = shot.side;
+		Scalar width = shot.width, height = shot.height, thickness = shot.thickness;
+		listsize[list] = Vec2f(width, height);
+		displist[list] = glGenLists(1);
+		glNewList(displist[list], GL_COMPILE);
 
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_COLOR, GL_ONE);
@@ -99,7 +115,7 @@ void Player::draw()
 			glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat_shininess);
 		}
 
-		Vec2f diff = Vec2f(width / 2.0f / 5.0f,	height / 2.0f / 5.0f);
+		Vec2f diff = Vec2f(toDouble(width) / 2.0 / 5.0, toDouble(height) / 2.0 / 5.0);
 
 		// this descibes the Z axis bending
 		double zmod[5][5][2][2] =
@@ -110,17 +126,18 @@ void Player::draw()
 			4, 3, 2, 1,	2, 1, 1, 0,	1, 0, 1, 0,	1, 0, 2, 1,	2, 1, 4, 3,
 			5, 4, 3, 2,	3, 2, 2, 1,	2, 1, 2, 1,	2, 1, 3, 2,	3, 2, 5, 4,
 		};
-		double z = thickness * (side == FRONT ? 1.0 : -1.0);
+		double z = toDouble(thickness) * (side == FRONT ? 1.0 : -1.0);
+		double dx = toDouble(diff.x), dy = toDouble(diff.y);
 		glTranslatef(0.0, 0.0, - 5.0 * z);
 		glBegin(GL_QUADS);
 			for (int x = -2; x < 3; x++)
 			{
 				for (int y = -2; y < 3; y++)
 				{
-					glVertex3f(x * diff.x*2.0 + diff.x, y * diff.y*2.0 - diff.y, zmod[x+2][y+2][0][0] * z);
-					glVertex3f(x * diff.x*2.0 - diff.x, y * diff.y*2.0 - diff.y, zmod[x+2][y+2][0][1] * z);
-					glVertex3f(x * diff.x*2.0 - diff.x, y * diff.y*2.0 + diff.y, zmod[x+2][y+2][1][1] * z);
-					glVertex3f(x * diff.x*2.0 + diff.x, y * diff.y*2.0 + diff.y, zmod[x+2][y+2][1][0] * z);
+					glVertex3f(x * dx*2.0 + dx, y * dy*2.0 - dy, zmod[x+2][y+2][0][0] * z);
+					glVertex3f(x * dx*2.0 - dx, y * dy*2.0 - dy, zmod[x+2][y+2][0][1] * z);
+					glVertex3f(x * dx*2.0 - dx, y * dy*2.0 + dy, zmod[x+2][y+2][1][1] * z);
+					glVertex3f(x * dx*2.0 + dx, y * dy*2.0 + dy, zmod[x+2][y+2][1][0] * z);
 				}
 			}
 		glEnd();
@@ -129,69 +146,119 @@ void Player::draw()
 		glEndList();
 	}
 	glPushMatrix();
-	glTranslatef(position.x, position.y, position.z);
-	glCallList(displist);
+	glTranslatef(toDouble(shot.position.x), toDouble(shot.position.y), toDouble(shot.position.z));
+	glCallList(displist[list]);
 	glPopMatrix();
 }
 
-Collision* Player::detectCol(const Vec3f& bposition, const Vec3f& bspeed, double radius)
+bool Player::hitQuad(const Vec3f& bposition, Scalar radius, int& qx, int& qy)
 {
-	// this function indeed is "work in progress"
-
-	// simple tests:
-	// wrong side
-	if ((side == BACK) == (bposition.z > 0)) return NULL;
+	// determine X,Y quad
+	qx = toInt(floor(fabs(bposition.x - position.x) / (width / 5.0)));
+	qy = toInt(floor(fabs(bposition.y - position.y) / (height / 5.0)));
 
-	//std::cout << fabs(bspeed.x) + fabs(bspeed.y) + fabs(bspeed.z) << std::endl;
+	// test if a quad is hit
+	if ((qx > 3)||(qy > 3)) return false;
+	// test if it could be with radius is missing   THIS HAS TO BE IMPROVED A LOT
+	if ((qx == 3)&&(fabs(bposition.x-radius - position.x) > width/2.0)) return false;
+	if ((qx == 3)&&(fabs(bposition.y-radius - position.y) > height/2.0)) return false;
+	return true;
+}
 
+bool Player::detectCol(const Vec3f& bposition, const Vec3f& bspeed, Scalar radius, Scalar& time, Collision& col)
+{
 	// cache the sign of our position (this is ! the sign of the ball speed)
-	double zSign = (side == FRONT ? 1.0 : -1.0);
+	Scalar zSign = (side == FRONT ? 1.0 : -1.0);
 
-	// not in range (ball is completely in front of the paddle or yet half beyond the paddle)
-	if ((bposition.z*zSign + radius < position.z*zSign - thickness*5.0)
-	  ||(bposition.z*zSign > position.z*zSign))
-	return NULL;
+	// from here on, the ball flies along +z towards us
+	Scalar bz = bposition.z * zSign;
+	Scalar vz = bspeed.z * zSign;
+	Scalar pz = position.z * zSign;
 
-	// determine X,Y quad
+	// a little hack:
+	// if the ball already flies in the right direction, it get's ignored
+	if (vz <= 0.0) return false;
 
-	struct vec2i {
-		int x, y;
-	} quadnum = {
-		(int)floor(fabs(bposition.x - position.x) / (width / 5.0f)),
-		(int)floor(fabs(bposition.y - position.y) / (height / 5.0f))
-	};
+	/* The paddle is bent: quad (x, y) lies x + y levels of thickness behind the front most one.
+	   So we step through the levels from the front to the back and take the first time the ball
+	   touches the level of the quad it is in front of at that moment. Even a very fast ball
+	   can't get through that way. */
+	for (int level = 0; level <= 6; level++)
+	{
+		Scalar absz = pz - thickness*(5.0 - level);
+		Scalar impact = std::max((absz - radius - bz) / vz, Scalar(0.0));
+		if (impact >= time) return false;
+
+		// the ball is already half beyond the paddle
+		if (bz + vz * impact > pz) return false;
+
+		Vec3f hit(bposition.x + bspeed.x * impact,
+			bposition.y + bspeed.y * impact,
+			bposition.z + bspeed.z * impact);
+
+		int qx, qy;
+		if (!hitQuad(hit, radius, qx, qy) || (qx + qy > level))
+			continue;
+
+		// we call it a hit
+		Vec2f slowed = slowedSpeed();
+		col.position = hit;
+		col.speed.x = bspeed.x + slowed.x * 200.0 + qx * 0.2 * (hit.x >= position.x ? 1.0 : -1.0);
+		col.speed.y = bspeed.y + slowed.y * 200.0 + qy * 0.2 * (hit.y >= position.y ? 1.0 : -1.0);
+		col.speed.z = -bspeed.z;
+		col.opponent = this;
+
+		time = impact;
+		return true;
+	}
+	return false;
+}
 
-	// test if a quad is hit
-	if ((quadnum.x > 3)||(quadnum.y > 3)) return NULL;
-	// test if it could be with radius is missing   THIS HAS TO BE IMPROVED A LOT
-	if ((quadnum.x == 3)&&(fabs(bposition.x-radius - position.x) > width/2.0)) return NULL;
-	if ((quadnum.x == 3)&&(fabs(bposition.y-radius - position.y) > height/2.0)) return NULL;
+bool Player::detectCol(const Vec2f& at, const Vec3f& bposition, const Vec3f& bspeed, Scalar radius, Scalar& time, Collision& col)
+{
+	Vec3f now = position;
+	position.x = at.x;
+	position.y = at.y;
+	bool hit = detectCol(bposition, bspeed, radius, time, col);
+	position = now;
+	return hit;
+}
 
-	// a little hack:
-	// if the ball already flies in the right direction, it get's ignored
-	if ((side == BACK) == (bspeed.z > 0)) return NULL;
-
-	double absz = position.z*zSign - thickness*(5.0 - (quadnum.x + quadnum.y));
-	if (bposition.z*zSign + radius < absz)
-		return NULL;
-
-	// we call it a hit
-	Collision* col = new Collision;
-	// we should use a better way to provide new positions
-	col->position.x = bposition.x;
-	col->position.y = bposition.y;
-	col->position.z = bposition.z;//absz * zSign;
-	col->speed.x = bspeed.x + speed.x * 200.0 + quadnum.x * 0.2 * (bposition.x >= position.x ? 1.0 : -1.0);
-	col->speed.y = bspeed.y + speed.y * 200.0 + quadnum.y * 0.2 * (bposition.y >= position.y ? 1.0 : -1.0);
-
-	double zSpeed = bspeed.z * zSign;
-	// we substract here what we added as quadnum values on x and y
-	//zSpeed -= (quadnum.x + quadnum.y) * 0.25;
-	//zSpeed = std::max(zSpeed, 0.1);
-	col->speed.z = zSpeed * -zSign;
-	std::cout << "*** HIT ***" << std::endl;
-
-	return col;
+void Player::remember(unsigned int tick)
+{
+	if ((pastcount > 0)&&((int)(tick - past[pastnewest].tick) < 0)) return;
+
+	// the player may see a step for a while, the latest position counts then
+	if ((pastcount == 0)||(past[pastnewest].tick != tick)) {
+		pastnewest = (pastnewest + 1) % HISTORY;
+		pastcount = std::min(pastcount + 1, (int)HISTORY);
+	}
+	past[pastnewest].tick = tick;
+	past[pastnewest].position = getPosition();
+}
+
+bool Player::recall(unsigned int tick, Vec2f& at)
+{
+	if ((pastcount == 0)||((int)(past[pastnewest].tick - tick) < 0)) return false;
+
+	// the oldest one if it's older than them all, though it might have been elsewhere still before
+	for (int i = 0; i < pastcount; i++)
+	{
+		at = past[(pastnewest + HISTORY - i) % HISTORY].position;
+		if ((int)(past[(pastnewest + HISTORY - i) % HISTORY].tick - tick) <= 0) break;
+	}
+	return true;
+}
+
+Scalar Player::nextEvent(const Vec3f& bposition, const Vec3f& bspeed, Scalar radius)
+{
+	// the same view as in detectCol(): the ball flies along +z towards us
+	Scalar zSign = (side == FRONT ? 1.0 : -1.0);
+	Scalar vz = bspeed.z * zSign;
+	if (vz <= 0.0) return std::numeric_limits<Scalar>::max();
+
+	Scalar front = position.z * zSign - thickness * 5.0;
+	return std::max((front - radius - bposition.z * zSign) / vz, Scalar(0.0));
 }
 
 void Player::attachBall(Ball* ball)
@@ -206,21 +273,15 @@ void Player::detachBall(double zSpeed)
 {
 	if (attachedBall != NULL)
 	{
-		attachedBall->setSpeed(Vec3f(speed.x * 500.0, speed.y * 500.0, (side == FRONT? -1.0 : 1.0) * zSpeed));
+		Vec2f slowed = slowedSpeed();
+		attachedBall->setSpeed(Vec3f(slowed.x * 500.0, slowed.y * 500.0, (side == FRONT? -1.0 : 1.0) * zSpeed));
 		attachedBall = NULL;
 	}
 }
 
-void Player::decelerate()
-{
-	speed.x = (speed.x > 0.0 ? 1 : -1) * std::max(0.0, fabs(speed.x) - 0.001f);
-	speed.y = (speed.x > 0.0 ? 1 : -1) * std::max(0.0, fabs(speed.y) - 0.001f);
-	//std::cout << std::endl << name << ":\t " << speed.x << "\t " << speed.y << std::endl;
-}
-
-void Player::action(Event event)
+Vec2f Player::slowedSpeed()
 {
-	if (event == DECELERATE) {
-		decelerate();
-	}
+	Scalar slowdown = Scalar(framework->getTime() - speedtime) * 0.001 / 25.0;
+	return Vec2f((speed.x > 0.0 ? 1.0 : -1.0) * std::max(Scalar(0.0), fabs(speed.x) - slowdown),
+		(speed.y > 0.0 ? 1.0 : -1.0) * std::max(Scalar(0.0), fabs(speed.y) - slowdown));
 }
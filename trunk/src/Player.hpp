@@ -2,6 +2,7 @@
 #define PLAYER_H
 
 #include <string>
+#include <cmath>
 #include "stuff.hpp"
 #include "Ball.hpp"
 #include "grapple/grapple.h"
@@ -11,8 +12,13 @@ class Framework;
 //! Player with paddle
 /* Describes a player with name and score in the game, who controls a paddle,
    which is also fully included into this class. */
-class Player : EventReceiver {
+class Player {
 public:
+	enum {
+		//! how many positions the paddle remembers, see remember()
+		HISTORY = 64
+	};
+
 	//! The constructor
 	/*!	\param control the game's Framework (ie Server or Client) object
 		\param nick the player's name
@@ -20,12 +26,6 @@ public:
 		\param z the absolute Z coordinate of the paddle; normally half of the field width
 	*/
 	Player(Framework* control, const std::string& nick, Side where, double z);
-	//! The destructor
-	~Player();
-
-	//! create necessary timer(s)
-	/*! does what can't be done while the object is on the stack */
-	void run();
 
 	//! returns the player name
 	inline const std::string& getName() { return name; }
@@ -33,6 +33,10 @@ public:
 	inline Side getSide() { return side; }
 	//! returns the actual position on the X and Y axis
 	inline Vec2f getPosition() { return Vec2f(position.x, position.y); }
+	//! returns how far the front of the paddle reaches from the field's center on the Z axis
+	inline Scalar getFront() { return fabs(position.z) - thickness * 5.0; }
+	//! returns the paddle's width and height
+	inline Vec2f getSize() { return Vec2f(width, height); }
 
 	inline grapple_user getID() { return id; }
 
@@ -40,7 +44,7 @@ public:
 	inline void setName(const std::string& nick) { name = nick; }
 
 	//! set the paddle size
-	/*! used to let Mr. Wand cheat
+	/*! once used to let Mr. Wand cheat
 		\param w width of the paddle
 		\param h height of the paddle
 	*/
@@ -51,6 +55,13 @@ public:
 		\param y position coordinate
 	*/
 	void setPosition(double x, double y);
+	//! set the paddle position as it was right after a move, to move on from there
+	/*! The Client uses this to replay the moves the Server hasn't seen yet on top of its position.
+		\param x position coordinate
+		\param y position coordinate
+		\param time timestamp in ticks (ms) of that move
+	*/
+	void setPosition(double x, double y, unsigned int time);
 
 	//! move as desired by the user
 	/*! This will test for barrieres and also against the maximum allowed speed of the paddle
@@ -59,21 +70,61 @@ public:
 		\param time actual timestamp in ticks (ms) for speed calculations
 	*/
 	void move(double x, double y, unsigned int time);
-	//! draw the paddle using GL functions
-	void draw();
 
-	//! test for collisions of a ball against the paddle
-	/*!	\param bposition the position to test for
-		\param bspeed the speed of the ball flying
+	//! note what is to be drawn of the paddle
+	/*!	\param shot the snapshot to fill
+	*/
+	void takeSnapshot(PaddleSnapshot& shot);
+	//! draw a paddle using GL functions, called by the render thread
+	/*! The paddles share a display list per side, the render thread's only.
+		\param shot the paddle as noted by takeSnapshot()
+	*/
+	static void draw(const PaddleSnapshot& shot);
+
+	//! sweep a ball against the paddle
+	/*!	\param bposition where the ball starts
+		\param bspeed the speed of the ball flying (units per second)
+		\param radius the ball's radius
+		\param time how long the ball flies (seconds); if there is a collision before, it is set to the time of impact
+		\param col filled with the according data at the time of impact, untouched if there is no collision
+		\result wether there was a collision in time
+	*/
+	bool detectCol(const Vec3f& bposition, const Vec3f& bspeed, Scalar radius, Scalar& time, Collision& col);
+	//! sweep a ball against the paddle as if it were somewhere else
+	/*! Used to rewind a remote player's paddle to where it was when the player saw the ball, see recall().
+		\param at the paddle's position on the X and Y axis
+		\param bposition where the ball starts
+		\param bspeed the speed of the ball flying (units per second)
 		\param radius the ball's radius
-		\result pointer to a Collision structure which provides the according data, NULL if there was no collision
+		\param time how long the ball flies (seconds); if there is a collision before, it is set to the time of impact
+		\param col filled with the according data at the time of impact, untouched if there is no collision
+		\result wether there was a collision in time
 	*/
-	Collision* detectCol(const Vec3f& bposition, const Vec3f& bspeed, double radius);
+	bool detectCol(const Vec2f& at, const Vec3f& bposition, const Vec3f& bspeed, Scalar radius, Scalar& time, Collision& col);
 
-	//! process a timer triggered event
-	/*!	\param event the event descriptor
+	//! note the position of the paddle, as the player had it while seeing a step of the game
+	/*! Called by the Server for a remote player after every move, and for every WorldState the
+	    player acknowledged, so a paddle standing still is remembered too. Only the latest HISTORY
+	    are kept, a step older than the latest one came late and is ignored.
+		\param tick the Server's step the player saw the ball at
+	*/
+	void remember(unsigned int tick);
+	//! returns where the paddle was while the player saw a step of the game
+	/*!	\param tick the Server's step
+		\param at filled with the position, the latest one remembered for that step or before
+		\result false if the player didn't see the step yet, as far as we know
+	*/
+	bool recall(unsigned int tick, Vec2f& at);
+
+	//! predict when a ball could next touch the paddle
+	/*! The paddle moves only on the X and Y axis, so this is when the ball reaches the front most
+	    level of the paddle on the Z axis, wherever the paddle is then.
+		\param bposition where the ball is
+		\param bspeed the speed of the ball flying (units per second)
+		\param radius the ball's radius
+		\result the time until then (seconds), 0 if it already could, the biggest Scalar if never
 	*/
-	void action(Event event);
+	Scalar nextEvent(const Vec3f& bposition, const Vec3f& bspeed, Scalar radius);
 
 	//! attach a Ball to the paddle
 	/*! The ball is attached and moves along with the paddle until the player decides to release it.
@@ -88,16 +139,26 @@ public:
 	*/
 	void detachBall(double zSpeed);
 private:
-	//! "slow down" the paddle
+	//! the "slowed down" speed of the paddle
 	/*! As the paddle isn't really moved with a speed (so the paddle doesn't have to slow down first
 	    when the user changes the movement direction) there is a speed value calculated from the last move.
-	    This value is the maximum of the stored speed and the new speed. Using a timer which cales decelerate(),
-	    the stored speed falls down continuously.
+	    This value is the maximum of the stored speed and the new speed. Since it was stored, it falls
+	    down continuously by 0.001 every 25 ms; there is no timer for it, it's worked out when needed.
+		\result the speed at the actual simulation time
 	*/
-	void decelerate();
+	Vec2f slowedSpeed();
+
+	//! determine which quad of the bent paddle a ball touches
+	/*!	\param bposition the ball's position
+		\param radius the ball's radius
+		\param qx the quad's distance from the center on the X axis
+		\param qy the quad's distance from the center on the Y axis
+		\result false if the ball misses the paddle
+	*/
+	bool hitQuad(const Vec3f& bposition, Scalar radius, int& qx, int& qy);
 
 	//! the maximum possible paddle movement speed
-	double maxspeed;
+	Scalar maxspeed;
 
 	//! pointer to the game's Framework (ie Server or Client) object
 	Framework* framework;
@@ -111,15 +172,17 @@ private:
 	//! speed, reasonably only X and Y
 	Vec2f speed;
 	//! width and height of the paddle
-	double width, height;
+	Scalar width, height;
 	//! how thick the paddle is (bending)
-	double thickness;
+	Scalar thickness;
 
-	//! timer used to decelerate
-	int deceltimer;
+	//! when the speed was stored (simulation time, ticks)
+	unsigned int speedtime;
 
-	//! GL displaylist descriptor
-	int displist;
+	//! GL displaylist descriptors for the FRONT and the BACK paddle
+	static int displist[2];
+	//! the paddle size the display lists were built for
+	static Vec2f listsize[2];
 
 	//! pointer to a Ball object ready to serve, if there is none, NULL
 	Ball* attachedBall;
@@ -127,6 +190,20 @@ private:
 	//! timestamp in ticks of the last movement
 	unsigned int lastmove;
 
+	//! a position the paddle had, see remember()
+	struct Past {
+		//! the Server's step the player saw
+		unsigned int tick;
+		//! the paddle's position on the X and Y axis
+		Vec2f position;
+	};
+	//! the positions remembered, the latest one at pastnewest
+	Past past[HISTORY];
+	//! how many positions are remembered
+	int pastcount;
+	//! the index of the latest position
+	int pastnewest;
+
 	grapple_user id;
 };
 
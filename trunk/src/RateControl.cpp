@@ -0,0 +1,58 @@
+#include "RateControl.hpp"
+#include <algorithm>
+
+//! the round trip may grow by this much above the shortest one before we call it congested (ms)
+static const double QUEUEING = 20.0;
+//! the share of WorldStates lost we call congested
+static const double LOSSY = 0.1;
+//! how much the shortest round trip grows per ping, so it follows a link which got slower for good (ms)
+static const double DRIFT = 1.0;
+
+RateControl::RateControl(int rate, unsigned int now)
+ : minperiod(1000.0 / std::max(1, rate)), period(minperiod), next(now), sends(0), acks(0),
+   rtt(0.0), minrtt(0.0), loss(0.0), keyframe(0), keyframetime(now)
+{}
+
+bool RateControl::due(unsigned int now)
+{
+	if (now < next) return false;
+	sends++;
+	next += period;
+	// after a pause or stall, start over instead of catching up
+	if (next < now)
+		next = now + period;
+	return true;
+}
+
+void RateControl::measured(double roundtrip)
+{
+	if (rtt == 0.0) {
+		rtt = minrtt = roundtrip;
+	} else {
+		rtt += (roundtrip - rtt) / 4.0;
+		minrtt = std::min(roundtrip, minrtt + DRIFT);
+	}
+
+	// the acknowledgements of the latest round trip are still on their way, that's alright
+	if (sends >= 4) {
+		double lost = 1.0 - std::min(1.0, (double)acks / sends);
+		loss += (lost - loss) / 4.0;
+	}
+	sends = acks = 0;
+
+	if ((loss > LOSSY)||(rtt - minrtt > std::max(QUEUEING, minrtt / 2.0)))
+		period = std::min((double)MAXPERIOD, period * 1.5);
+	else	period = std::max(minperiod, period - 4.0);
+}
+
+bool RateControl::mayKeyframe(unsigned int now)
+{
+	// a round trip, and the time until the next WorldState on top, which would tell us about it
+	return (keyframe == 0)||(now - keyframetime > rtt + period + 20.0);
+}
+
+void RateControl::sentKeyframe(unsigned int tick, unsigned int now)
+{
+	keyframe = tick;
+	keyframetime = now;
+}
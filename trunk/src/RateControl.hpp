@@ -0,0 +1,75 @@
+#ifndef RATECONTROL_H
+#define RATECONTROL_H
+
+//! Picks how often a single Client gets a WorldState, from how its link does
+/*! The Server pings every Client and counts how many of the WorldStates it sent were acknowledged.
+    While the round trip stays near the shortest one seen lately and hardly anything gets lost, the
+    Client gets up to the rate asked for (see Configuration::worldrate). If the round trip grows,
+    which means packets are queued somewhere on the way, or more than a tenth of them gets lost, the
+    time between two states grows by half, up to MAXPERIOD; afterwards it shrinks again slowly.
+    A congested Client thereby gets less, and the Server doesn't spend its time on packets which
+    would only wait in a queue.
+    Keyframes are budgeted the same way: after one was sent, the next one waits for a round trip,
+    and the WorldStates meanwhile are deltas against it, which the Client can decode if it got it.
+*/
+class RateControl
+{
+public:
+	enum {
+		//! the longest time between two WorldStates (ticks)
+		MAXPERIOD = 100
+	};
+
+	//! The constructor
+	/*!	\param rate the most WorldStates per second
+		\param now the actual time (ticks)
+	*/
+	RateControl(int rate = 125, unsigned int now = 0);
+
+	//! wether the next WorldState is due, then it's taken as sent
+	/*!	\param now the actual time (ticks)
+	*/
+	bool due(unsigned int now);
+	//! a WorldState arrived, as its acknowledgement tells
+	inline void acked() { acks++; }
+	//! a ping came back, which adjusts the rate
+	/*!	\param rtt the round trip (ms)
+	*/
+	void measured(double rtt);
+
+	//! wether a keyframe may be sent, or the latest one is still on its way
+	/*!	\param now the actual time (ticks)
+	*/
+	bool mayKeyframe(unsigned int now);
+	//! a keyframe was sent
+	/*!	\param tick the WorldState's tick
+		\param now the actual time (ticks)
+	*/
+	void sentKeyframe(unsigned int tick, unsigned int now);
+	//! returns the tick of the latest keyframe sent
+	inline unsigned int getKeyframe() { return keyframe; }
+
+	//! returns how many WorldStates per second the Client gets at the moment
+	inline double getRate() { return 1000.0 / period; }
+	//! returns the round trip, on average (ms)
+	inline double getRoundTrip() { return rtt; }
+	//! returns how many of the WorldStates get lost (or their acknowledgements), on average
+	inline double getLoss() { return loss; }
+private:
+	//! the shortest time between two WorldStates (ticks)
+	double minperiod;
+	//! the time between two WorldStates at the moment (ticks)
+	double period;
+	//! when the next WorldState is due (ticks, with fractions)
+	double next;
+	//! WorldStates sent and acknowledged since the latest ping came back
+	unsigned int sends, acks;
+	//! the round trip on average, and the shortest one lately (ms); 0 until measured
+	double rtt, minrtt;
+	//! the share of WorldStates lost, on average
+	double loss;
+	//! the tick of the latest keyframe sent, 0 for none, and when it was sent (ticks)
+	unsigned int keyframe, keyframetime;
+};
+
+#endif
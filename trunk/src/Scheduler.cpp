@@ -0,0 +1,268 @@
+#include "Scheduler.hpp"
+#include "Framework.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <unistd.h>
+#include <sys/time.h>
+
+//! how many latencies are kept per game
+static const unsigned int samples = 256;
+
+//! wall clock in microseconds
+static double usecs()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+//! returns a percentile of some values, which get reordered
+static unsigned int percentile(std::vector<unsigned int>& values, double p)
+{
+	if (values.empty()) return 0;
+	std::vector<unsigned int>::iterator nth = values.begin() + (int)((values.size() - 1) * p);
+	std::nth_element(values.begin(), nth, values.end());
+	return *nth;
+}
+
+void Scheduler::Latency::add(unsigned int usec)
+{
+	if (sample.size() < samples)
+		sample.push_back(usec);
+	else	sample[next] = usec;
+	next = (next + 1) % samples;
+	max = std::max(max, usec);
+}
+
+Scheduler::Scheduler(int threads)
+: lock(SDL_CreateMutex()), start(SDL_CreateCond()), done(SDL_CreateCond()),
+  generation(0), pending(0), quit(false), now(0), begin(0.0), cpulast(clock())
+{
+	if (threads <= 0)
+		threads = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+
+	for (int i = 0; i < threads; i++)
+	{
+		Worker* w = new Worker;
+		w->pool = this;
+		w->number = i;
+		w->lock = SDL_CreateMutex();
+		worker.push_back(w);
+	}
+	// only start them when the vector doesn't change anymore, they steal from each other
+	for (int i = 0; i < threads; i++)
+		worker[i]->thread = SDL_CreateThread(work, worker[i]);
+}
+
+Scheduler::~Scheduler()
+{
+	SDL_LockMutex(lock);
+	quit = true;
+	SDL_CondBroadcast(start);
+	SDL_UnlockMutex(lock);
+
+	for (int i = 0; i < worker.size(); i++)
+	{
+		SDL_WaitThread(worker[i]->thread, NULL);
+		SDL_DestroyMutex(worker[i]->lock);
+		delete worker[i];
+	}
+	SDL_DestroyCond(done);
+	SDL_DestroyCond(start);
+	SDL_DestroyMutex(lock);
+
+	for (int i = 0; i < game.size(); i++)
+		delete game[i];
+}
+
+void Scheduler::add(Framework* g)
+{
+	game.push_back(g);
+	alive.push_back(true);
+	latency.push_back(Latency());
+	latency.back().sample.reserve(samples);
+}
+
+int Scheduler::work(void* data)
+{
+	Worker* self = (Worker*)data;
+	Scheduler* pool = self->pool;
+	int generation = 0;
+
+	for (;;)
+	{
+		SDL_LockMutex(pool->lock);
+		while ((pool->generation == generation)&&(!pool->quit))
+			SDL_CondWait(pool->start, pool->lock);
+		if (pool->quit) {
+			SDL_UnlockMutex(pool->lock);
+			return 0;
+		}
+		generation = pool->generation;
+		SDL_UnlockMutex(pool->lock);
+
+		int task, count = 0;
+		while (pool->take(self->number, task))
+		{
+			pool->execute(task);
+			count++;
+		}
+
+		SDL_LockMutex(pool->lock);
+		pool->pending -= count;
+		if (pool->pending == 0)
+			SDL_CondSignal(pool->done);
+		SDL_UnlockMutex(pool->lock);
+	}
+}
+
+bool Scheduler::take(int number, int& task)
+{
+	// our own queue first, the newest task
+	Worker* self = worker[number];
+	SDL_LockMutex(self->lock);
+	if (!self->tasks.empty()) {
+		task = self->tasks.back();
+		self->tasks.pop_back();
+		SDL_UnlockMutex(self->lock);
+		return true;
+	}
+	SDL_UnlockMutex(self->lock);
+
+	// then the oldest task of any other worker
+	for (int i = 1; i < worker.size(); i++)
+	{
+		Worker* victim = worker[(number + i) % worker.size()];
+		SDL_LockMutex(victim->lock);
+		if (!victim->tasks.empty()) {
+			task = victim->tasks.front();
+			victim->tasks.pop_front();
+			SDL_UnlockMutex(victim->lock);
+			return true;
+		}
+		SDL_UnlockMutex(victim->lock);
+	}
+	return false;
+}
+
+void Scheduler::execute(int task)
+{
+	if (!game[task]->tick(now))
+		alive[task] = false;
+	latency[task].add((unsigned int)(usecs() - begin));
+}
+
+int Scheduler::round(unsigned int time)
+{
+	if (game.empty())
+		return 0;
+
+	now = time;
+	begin = usecs();
+
+	SDL_LockMutex(lock);
+	// set before dealing out, a thread still busy with the last round may already take a task
+	pending = game.size();
+	for (int i = 0; i < game.size(); i++)
+	{
+		Worker* w = worker[i % worker.size()];
+		SDL_LockMutex(w->lock);
+		w->tasks.push_back(i);
+		SDL_UnlockMutex(w->lock);
+	}
+	generation++;
+	SDL_CondBroadcast(start);
+	while (pending > 0)
+		SDL_CondWait(done, lock);
+	SDL_UnlockMutex(lock);
+
+	for (int i = game.size() - 1; i >= 0; i--)
+	{
+		if (!alive[i]) {
+			delete game[i];
+			game.erase(game.begin() + i);
+			alive.erase(alive.begin() + i);
+			latency.erase(latency.begin() + i);
+		}
+	}
+	return game.size();
+}
+
+void Scheduler::run()
+{
+	SDL_Event event;
+	unsigned int reported = SDL_GetTicks();
+	unsigned int rounds = 0;
+
+	while (!game.empty())
+	{
+		/* only the process as a whole can be asked to quit */
+		while (SDL_PollEvent(&event))
+			if (event.type == SDL_QUIT)
+				return;
+
+		unsigned int time = SDL_GetTicks();
+		unsigned int step = game[0]->getTimestep();
+		round(time);
+		rounds++;
+
+		if (time - reported >= 10000) {
+			report(time - reported, rounds);
+			reported = time;
+			rounds = 0;
+		}
+
+		/* every game sleeps until its next step is due, so do we */
+		unsigned int spent = SDL_GetTicks() - time;
+		if (spent < step)
+			SDL_Delay(step - spent);
+	}
+}
+
+void Scheduler::getStats(unsigned int& p50, unsigned int& p99, unsigned int& max, int& worst)
+{
+	std::vector<unsigned int> all;
+	unsigned int highest = 0;
+	max = 0;
+	worst = -1;
+
+	for (int i = 0; i < latency.size(); i++)
+	{
+		std::vector<unsigned int> own = latency[i].sample;
+		unsigned int p = percentile(own, 0.99);
+		if ((worst == -1)||(p > highest)) {
+			highest = p;
+			worst = i;
+		}
+		max = std::max(max, latency[i].max);
+		all.insert(all.end(), latency[i].sample.begin(), latency[i].sample.end());
+	}
+	p50 = percentile(all, 0.5);
+	p99 = percentile(all, 0.99);
+}
+
+void Scheduler::resetStats()
+{
+	for (int i = 0; i < latency.size(); i++)
+		latency[i] = Latency();
+}
+
+void Scheduler::report(unsigned int elapsed, unsigned int ticks)
+{
+	clock_t time = clock();
+	// processor time in ms, including the networking threads
+	double cpu = 1000.0 * (double)(time - cpulast) / CLOCKS_PER_SEC;
+	cpulast = time;
+
+	unsigned int p50, p99, max;
+	int worst;
+	getStats(p50, p99, max, worst);
+
+	std::cout << "Load: " << game.size() << " games on " << worker.size() << " threads, "
+		<< floor(ticks * 10000.0 / elapsed + 0.5) / 10.0 << " rounds/s, "
+		<< floor(cpu * 1000.0 / elapsed + 0.5) / 10.0 << "% of a core" << std::endl;
+	std::cout << "Tick latency: p50 " << p50 << " us, p99 " << p99 << " us, max " << max
+		<< " us, worst game #" << worst << std::endl;
+	resetStats();
+}
@@ -0,0 +1,143 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <vector>
+#include <deque>
+#include <ctime>
+#include "SDL.h"
+
+class Framework;
+
+//! Runs many games in one process on a pool of threads
+/*! Every round, the tick() of each game is a task. The tasks are dealt out to the threads' own queues;
+    a thread running out of work steals from the others, so a busy game (say in multiball mode)
+    doesn't hold back the ones queued behind it. A round is over when all tasks are done, then the
+    finished games are removed and the next round starts one timestep later.
+    A game is only ever ticked by one thread at a time, so the games themselves need no locking.
+*/
+class Scheduler
+{
+public:
+	//! The constructor, starting the threads
+	/*!	\param threads how many threads run the games; 0 for one per processor
+	*/
+	Scheduler(int threads);
+	//! The destructor, stopping the threads and deleting the games left
+	~Scheduler();
+
+	//! add a game, which will be deleted by the Scheduler
+	/*!	\param game the game, not running its own loop()
+	*/
+	void add(Framework* game);
+
+	//! returns how many games there are
+	inline int size() { return game.size(); }
+	//! returns how many threads run the games
+	inline int getThreads() { return worker.size(); }
+
+	//! run the games until all of them are finished or the process is asked to quit
+	void run();
+
+	//! tick every game once, spread over the threads
+	/*! returns when all games are done and the finished ones are removed
+		\param now the time to tick the games to (ticks, ms)
+		\result how many games are left
+	*/
+	int round(unsigned int now);
+
+	//! sum up the latest tick latencies of all games
+	/*! A tick's latency is the time from the start of its round until the game is done with it,
+	    so it includes waiting for a thread.
+		\param p50 filled with the median latency (us)
+		\param p99 filled with the 99th percentile (us)
+		\param max filled with the maximum latency since the last resetStats() (us)
+		\param worst filled with the index of the game with the highest 99th percentile
+	*/
+	void getStats(unsigned int& p50, unsigned int& p99, unsigned int& max, int& worst);
+	//! forget the latencies collected so far
+	void resetStats();
+private:
+	//! the latest tick latencies of a game
+	struct Latency {
+		inline Latency() : next(0), max(0) {}
+		//! add a latency, overwriting the oldest one if there are enough
+		void add(unsigned int usec);
+
+		//! latencies in us, used as a ring
+		std::vector<unsigned int> sample;
+		//! where the next latency goes
+		int next;
+		//! the highest latency
+		unsigned int max;
+	};
+
+	//! a thread with its own queue of tasks
+	struct Worker {
+		//! the Scheduler the thread belongs to
+		Scheduler* pool;
+		//! the worker's index
+		int number;
+		//! the SDL thread
+		SDL_Thread* thread;
+		//! protects tasks
+		SDL_mutex* lock;
+		//! indices of the games still to be ticked in this round
+		std::deque<int> tasks;
+	};
+
+	//! the function run by every worker thread
+	/*!	\param data the Worker
+	*/
+	static int work(void* data);
+
+	//! get the next task to do
+	/*! Takes the newest task from the worker's own queue, or steals the oldest one from another worker.
+		\param number the worker's index
+		\param task filled with the task
+		\result false if there is nothing left to do
+	*/
+	bool take(int number, int& task);
+
+	//! tick a game and note how long it took since the round started
+	/*!	\param task the game's index
+	*/
+	void execute(int task);
+
+	//! print the games' load and latencies, called by run()
+	/*!	\param elapsed ticks (ms) passed since the last report
+		\param ticks rounds done since the last report
+	*/
+	void report(unsigned int elapsed, unsigned int ticks);
+
+	//! the hosted games
+	std::vector<Framework*> game;
+	//! wether a game is still running, written by the worker ticking it
+	std::vector<char> alive;
+	//! the tick latencies of every game
+	std::vector<Latency> latency;
+
+	//! the threads
+	std::vector<Worker*> worker;
+
+	//! protects generation, pending and quit
+	SDL_mutex* lock;
+	//! signalled when a round starts
+	SDL_cond* start;
+	//! signalled when the last task of a round is done
+	SDL_cond* done;
+	//! number of the actual round
+	int generation;
+	//! tasks of the actual round not done yet
+	int pending;
+	//! tells the threads to end
+	bool quit;
+
+	//! the time the games get ticked to in the actual round (ms)
+	unsigned int now;
+	//! wall clock time the actual round started (us)
+	double begin;
+	//! processor time used by the process at the last report
+	clock_t cpulast;
+};
+
+#endif
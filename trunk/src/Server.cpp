@@ -1,17 +1,20 @@
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include "Server.hpp"
 #include "Client.hpp"
 #include "Buffer.hpp"
 
 Server::Server(void *surf, const Configuration& conf)
- : Framework(surf, conf, UNINITIALIZED), ballouttimer(-1), ballspeed(6.0)
+ : Framework(surf, conf, UNINITIALIZED), ballouttimer(-1), ballspeed(6.0), tick(0),
+   worldrate(conf.worldrate), pinged(getTime()), reported(getTime())
 {
+	miss.player = NULL;
 	ball.push_back(Ball(this));
+	multiball.spawn(conf.multiball, field, ballspeed);
 	player.push_back(new Player(this, "Mr. Wand", BACK, field.getLength()/2.0f));
-	// Mr. Wand is cheating!
-	player[0]->setSize(3.5, 3.5); // *****************
-	player[0]->run();
+	// Mr. Wand doesn't cheat anymore, he just knows where the ball goes
+	bot.push_back(Bot(player[0]));
 	resetScore();
 	output.addMessage(Interface::WAITING_FOR_OPPONENT);
 
@@ -20,14 +23,12 @@ Server::Server(void *surf, const Configuration& conf)
 
 	if (server == -1 || loopback == -1)
 		shutdown();
-
-	loop();
 }
 
 Server::~Server()
 {
-	grapple_server_destroy(server);
-	exit(0);
+	if (loopback != -1) grapple_client_destroy(loopback);
+	if (server != -1) grapple_server_destroy(server);
 }
 
 grapple_server Server::initNetwork(const std::string& version, const std::string& name, const unsigned short port)
@@ -55,29 +56,27 @@ void Server::movePaddle(double x, double y, unsigned int time)
 	if (state == UNINITIALIZED)
 		return;
 
-	// we move it ourselves.. the client will report it to the server
+	// we move it ourselves, the clients see it with the next WorldState
 	Player* player = peer[localid].player;
 	player->move(x, y, time);
-	if (state == RUNNING) {
-		Vec2f pos = player->getPosition();
-		Buffer sbuf(PADDLEPOSITION);
-		sbuf.pushId(localid);
-		sbuf.pushDouble(pos.y);
-		sbuf.pushDouble(pos.x);
-		sendPacket(sbuf, false);
-	}
 }
 
 void Server::updateGame(int ticks)
 {
 	if (paused == 0) {
+		tick++;
+		for (int i = 0; i < bot.size(); i++)
+			bot[i].update(ball[0], field, getTime());
+		watchMiss(ticks);
 		ball[0].move(ticks);
-		if (state == RUNNING) {
-			Buffer sbuf(BALLPOSITION);
-			const Vec3f& pos = ball[0].getPosition();
-			sbuf.pushDouble(pos.x); sbuf.pushDouble(pos.y); sbuf.pushDouble(pos.z);
-			sendPacket(sbuf, false);
-		}
+		// bounced back, by the paddle as it is or anything else
+		if ((miss.player != NULL)&&((miss.speed.z > 0.0) != (ball[0].getSpeed().z > 0.0)))
+			miss.player = NULL;
+		resolveMiss(ticks);
+		multiball.move(ticks, field, player);
+		// every client gets the world at its own rate, however often the paddles moved
+		if (state == RUNNING)
+			sendWorld();
 	}
 }
 
@@ -93,6 +92,10 @@ void Server::resetScore()
 
 void Server::doScore(Side side)
 {
+	// the player may still have hit it, as far as the player could see
+	if ((miss.player != NULL)&&(miss.player->getSide() == side))
+		return;
+
 	if (ballouttimer == -1)
 	{
 		// we didn't process it already
@@ -125,6 +128,58 @@ void Server::doScore(Side side)
 	}
 }
 
+void Server::watchMiss(int ticks)
+{
+	if ((miss.player != NULL)||(state != RUNNING)) return;
+
+	Vec3f position = ball[0].getPosition();
+	Vec3f speed = ball[0].getSpeed();
+	for (std::map<grapple_user, Peer>::iterator i = peer.begin(); i != peer.end(); ++i)
+	{
+		Player* remote = i->second.player;
+		if ((i->first == localid)||(remote == NULL)) continue;
+
+		// does the ball reach the paddle's front within this step?
+		Scalar until = remote->nextEvent(position, speed, ball[0].getRadius());
+		if ((until <= 0.0)||(toDouble(until) * 1000.0 >= ticks)) continue;
+
+		miss.player = remote;
+		miss.id = i->first;
+		miss.tick = tick;
+		miss.time = getTime() + (unsigned int)(toDouble(until) * 1000.0);
+		miss.position = Vec3f(position.x + speed.x * until, position.y + speed.y * until, position.z + speed.z * until);
+		miss.speed = speed;
+		return;
+	}
+}
+
+void Server::resolveMiss(int ticks)
+{
+	if (miss.player == NULL) return;
+
+	Vec2f at;
+	if (!miss.player->recall(miss.tick, at)) {
+		// the player didn't see the ball get there yet, we wait for it a little
+		if ((int)(getTime() - miss.time) < REWIND) return;
+		at = miss.player->getPosition();
+	}
+
+	Peer& client = peer[miss.id];
+	client.rewinds++;
+	Scalar impact = 1.0;
+	Collision col;
+	if (miss.player->detectCol(at, miss.position, miss.speed, ball[0].getRadius(), impact, col)) {
+		// it bounced off the paddle back then, and flies on from there until the end of this step
+		client.saves++;
+		ball[0].setPosition(col.position);
+		ball[0].setSpeed(col.speed);
+		int late = (int)(getTime() + ticks - miss.time) - (int)(toDouble(impact) * 1000.0);
+		if (late > 0)
+			ball[0].move(late);
+	}
+	miss.player = NULL;
+}
+
 void Server::serveBall()
 {
 	output.removeMessage(Interface::YOU_SERVE);
@@ -160,6 +215,8 @@ void Server::action(Event event)
 				sbuf.pushId(localid);
 				sendPacket(sbuf, true);
 			}
+			// nobody sits in front of a dedicated server to click
+			if (headless) serveBall();
 		}
 		removeTimer(ballouttimer);
 		ballouttimer = -1;
@@ -167,7 +224,7 @@ void Server::action(Event event)
 }
 
 
-// the client sends the ping
+// the clients send their pings, we ping them along with the WorldStates
 void Server::ping() {}
 
 void Server::doNetworking()
@@ -211,19 +268,36 @@ void Server::doNetworking()
 				break;
 				case PADDLEMOVE:
 					{
+						// a movement overtaken by a later one comes too late, the client moved on already
+						unsigned int seq = buf.popVarint();
+						if ((int)(seq - peer[id].moved) <= 0) break;
+						peer[id].moved = seq;
+						unsigned int seen = buf.popVarint();
 						unsigned int time = buf.popInt();
-						peer[id].player->move(buf.popDouble(), buf.popDouble(), time);
-						Vec2f pos = peer[id].player->getPosition();
-						Buffer sbuf(PADDLEPOSITION);
-						sbuf.pushId(id);
-						sbuf.pushDouble(pos.y);
-						sbuf.pushDouble(pos.x);
-						sendPacket(sbuf, false);
+						// the client sends y first, and x as seen from our side
+						double y = buf.popFixed();
+						double x = buf.popFixed();
+						peer[id].player->move(x, y, time);
+						if (seen != 0)
+							peer[id].player->remember(seen);
 					}
 				break;
 				case SERVE_BALL:
 					peer[id].player->detachBall(ballspeed);
 					break;
+				case WORLD_ACK:
+					{
+						// they may arrive out of order, the latest one counts
+						unsigned int acked = buf.popVarint();
+						unsigned int seen = buf.popVarint();
+						peer[id].rate.acked();
+						if ((int)(acked - peer[id].acked) > 0)
+							peer[id].acked = acked;
+						// the paddle is where it was after the latest movement, while the player sees this
+						if (seen != 0)
+							peer[id].player->remember(seen);
+					}
+					break;
 				case PAUSE_REQUEST:
 					togglePause(true, true);
 					std::cout << "Player " << peer[id].name << " paused the game." << std::endl;
@@ -235,6 +309,10 @@ void Server::doNetworking()
 				}
 			break;
 			}
+		case GRAPPLE_MSG_PING:
+			// a ping sent by sendWorld() came back, grapple measures in microseconds
+			peer[message->PING.id].rate.measured(message->PING.pingtime / 1000.0);
+		break;
 		case GRAPPLE_MSG_USER_DISCONNECTED:
 			std::cout << "Player " << peer[message->USER_DISCONNECTED.id].name << " disconnected!" << std::endl;
 			shutdown();
@@ -252,10 +330,13 @@ void Server::doNetworking()
 				localid = message->NEW_USER.id;
 				peer[localid].player = new Player(this, peer[localid].name, FRONT, field.getLength()/2.0f);
 				player.push_back(peer[localid].player);
+				// on a dedicated server, our own seat is taken by a second Mr. Wand
+				if (headless) bot.push_back(Bot(peer[localid].player));
 				peer[localid].player->attachBall(&ball[0]);
 				output.addMessage(Interface::YOU_SERVE);
 				peer[localid].ready = true;
 				state = WAITING;
+				if (headless) serveBall();
 			}
 			break;
 		}
@@ -275,14 +356,15 @@ void Server::startGame()
 	// create new players
 	delete player[0];	delete player[1];
 	player.clear();
+	bot.clear();
 
 	for (std::map<grapple_user, Peer>::iterator i = peer.begin(); i != peer.end(); ++i)
 	{
 		Side side = (i->first == localid ? FRONT : BACK);
 		i->second.player = new Player(this, i->second.name, side, field.getLength()/2.0f);
 		player.push_back(i->second.player);
-		i->second.player->run();
 	}
+	if (headless) bot.push_back(Bot(peer[localid].player));
 
 	// now we are up & ..
 	state = RUNNING;
@@ -298,16 +380,91 @@ void Server::startGame()
 	else
 		sendSimplePacket(RESUME_REQUEST);
 
-	// tell our initial position
-	Vec2f pos = peer[localid].player->getPosition();
-	Buffer sbuf(PADDLEPOSITION);
-	sbuf.pushId(localid);
-	sbuf.pushDouble(pos.y);
-	sbuf.pushDouble(pos.x);
-	sendPacket(sbuf, false);
+	// the positions follow with the first WorldState, a keyframe
+	for (std::map<grapple_user, Peer>::iterator i = peer.begin(); i != peer.end(); ++i)
+		i->second.rate = RateControl(worldrate, getTime());
 }
 
 void Server::sendPacket(Buffer& data, bool reliable)
 {
 	grapple_server_send(server, GRAPPLE_EVERYONE, reliable * GRAPPLE_RELIABLE, data.getData(), data.getSize());
 }
+
+void Server::sendPacketTo(grapple_user id, Buffer& data, bool reliable)
+{
+	grapple_server_send(server, id, reliable * GRAPPLE_RELIABLE, data.getData(), data.getSize());
+}
+
+void Server::sendWorld()
+{
+	WorldState world;
+	world.tick = tick;
+	world.setBall(ball[0].getPosition());
+	for (std::map<grapple_user, Peer>::iterator i = peer.begin(); i != peer.end(); ++i)
+		if (i->second.player != NULL)
+			world.addPaddle(i->first, i->second.player->getPosition());
+	sent.store(world);
+
+	// an empty state as base makes a keyframe
+	const WorldState keyframe;
+	for (std::map<grapple_user, Peer>::iterator i = peer.begin(); i != peer.end(); ++i)
+	{
+		// our own loopback client doesn't need it
+		if (i->first == localid) continue;
+		RateControl& rate = i->second.rate;
+		if (!rate.due(getTime())) continue;
+
+		const WorldState* base = sent.find(i->second.acked);
+		if ((base == NULL)||(!base->sameLayout(world))) {
+			// while the latest keyframe is on its way, we send deltas against it
+			base = sent.find(rate.getKeyframe());
+			if ((base == NULL)||(!base->sameLayout(world))||(rate.mayKeyframe(getTime()))) {
+				base = &keyframe;
+				rate.sentKeyframe(world.tick, getTime());
+				i->second.keyframes++;
+			}
+		}
+		Buffer sbuf(WORLD);
+		world.write(sbuf, *base);
+		// the client predicts its paddle, this tells it which of its movements are in
+		sbuf.pushVarint(i->second.moved);
+		sendPacketTo(i->first, sbuf, false);
+		i->second.states++;
+		i->second.bytes += sbuf.getSize();
+	}
+
+	// the round trips drive the rates; Framework's ping() isn't called for a dedicated server
+	if (getTime() - pinged >= 500) {
+		for (std::map<grapple_user, Peer>::iterator i = peer.begin(); i != peer.end(); ++i)
+			if (i->first != localid)
+				grapple_server_ping(server, i->first);
+		pinged = getTime();
+	}
+
+	if (getTime() - reported >= 10000) {
+		reportBandwidth(getTime() - reported);
+		reported = getTime();
+	}
+}
+
+void Server::reportBandwidth(unsigned int elapsed)
+{
+	for (std::map<grapple_user, Peer>::iterator i = peer.begin(); i != peer.end(); ++i)
+	{
+		Peer& client = i->second;
+		if ((i->first == localid)||(client.states == 0)) continue;
+
+		// the payload only, grapple and UDP add their headers to every packet
+		std::cout << "World to " << client.name << ": " << ::round(client.bytes * 10000.0 / elapsed) / 10.0 << " bytes/s, "
+			<< ::round(client.bytes * 10.0 / client.states) / 10.0 << " bytes per state, "
+			<< ::round(client.keyframes * 1000.0 / client.states) / 10.0 << "% keyframes, "
+			<< ::round(client.rate.getRate()) << " states/s at " << ::round(client.rate.getRoundTrip()) << " ms round trip, "
+			<< ::round(client.rate.getLoss() * 1000.0) / 10.0 << "% lost" << std::endl;
+		client.states = client.keyframes = client.bytes = 0;
+
+		if (client.rewinds > 0)
+			std::cout << "Rewound " << client.name << "'s paddle " << client.rewinds << " times, "
+				<< client.saves << " of them turned a miss into a hit" << std::endl;
+		client.rewinds = client.saves = 0;
+	}
+}
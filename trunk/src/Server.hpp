@@ -2,23 +2,26 @@
 #define SERVER_H
 
 #include "Framework.hpp"
+#include "Bot.hpp"
+#include "WorldState.hpp"
 
 //! The Server is not only a network listening server but actually master of the gameflow.
 /*! Even if this were a single player game (well, it's kind of hard against Mr. Wand)
     we would need the server as the instance caring about everything running right.
 */
-class Server : Framework, EventReceiver
+class Server : public Framework, EventReceiver
 {
 public:
 	//! constructor which initiates the game against Mr.Wand
-	/*!	\param surf pointer to the SDL video surface created in main.cpp
+	/*! The game is run by loop(), or by tick() if several games share the process.
+		\param surf pointer to the SDL video surface created in main.cpp
 		\param conf a Configuration structure created in main.cpp and filled with configuration from the commandline
 	*/
 	Server(void *surf, const Configuration& conf);
 
 	//! deconstructor, which tells perhaps connected clients about our suicide
-	/* To prevent any concurrancy to break up stuff, this hardly kills the game with exit().
-	   Note that due to the atexit() registration this will lead to a proper deinitialization of SDL & others.
+	/* Other games hosted by the same process go on, so this doesn't exit() anymore.
+	   The process ends by returning from main(), where the atexit() registration takes care of SDL & others.
 	*/
 	~Server();
 
@@ -26,7 +29,8 @@ public:
 
 private:
 	//! process the player's desire to move on
-	/*! The according Paddle is called to move itself and every Client is notified of the new position
+	/*! The according Paddle is called to move itself, the Clients get its position with the next WorldState.
+	    Called at most once per step, see Framework::processInput().
 		\param x desired movement on the X axis
 		\param y desired movement on the Y axis
 		\param time the actual timestamp (ticks) to determine the elapsed time value since the last move
@@ -61,8 +65,44 @@ private:
 
 	void sendPacket(Buffer& data, bool reliable);
 
+	//! send a packet to a single client
+	/*!	\param id the client
+		\param data the packet
+		\param reliable wether it has to arrive
+	*/
+	void sendPacketTo(grapple_user id, Buffer& data, bool reliable);
+
+	//! notice if the ball reaches a remote player's paddle within this step, called by updateGame() before it moves
+	/*! The paddle's position is the one the player set half a round trip ago, looking at a ball
+	    shown a little in the past on top. If the ball gets past it, the score waits (see resolveMiss()).
+		\param ticks the step's length
+	*/
+	void watchMiss(int ticks);
+
+	//! decide about a ball which got past a remote player's paddle
+	/*! Once we know where the paddle was while the player saw the ball get there, the paddle is
+	    rewound to that position and the ball is tested against it again. If it hits, the ball flies
+	    on from there as if the paddle had been there all along. We wait REWIND ticks at most, then the
+	    paddle's actual position is taken.
+		\param ticks the step's length, the ball has been moved by it already
+	*/
+	void resolveMiss(int ticks);
+
+	//! send the ball and paddles to every client in a single packet, called by updateGame() every step
+	/*! Each client gets a delta against the latest WorldState it acknowledged, or a keyframe,
+	    whenever its RateControl says so. Every 500 ms the clients are pinged for it. */
+	void sendWorld();
+
+	//! print how many bytes of WorldStates every client got at which rate, and how often its paddle was rewound, called by sendWorld()
+	/*!	\param elapsed ticks (ms) passed since the last report
+	*/
+	void reportBandwidth(unsigned int elapsed);
+
 	void startGame();
 
+	//! the Mr. Wands, moving the paddles nobody sits in front of
+	std::vector<Bot> bot;
+
 	//! descriptor (index) of the timer used when the ball flies out after a score
 	int ballouttimer;
 	//! the ball's initial Z axis speed when it get's served
@@ -75,6 +115,33 @@ private:
 
 	int score[2];
 
+	//! the WorldStates sent lately, the bases of the deltas
+	WorldHistory sent;
+	//! the number of the actual step, which the WorldStates carry
+	unsigned int tick;
+	//! the most WorldStates per second a client gets, see Configuration::worldrate and RateControl
+	int worldrate;
+	//! when the clients were pinged last (ticks)
+	unsigned int pinged;
+	//! when reportBandwidth() was called last (ticks)
+	unsigned int reported;
+
+	enum {
+		//! how long a ball which got past a remote player's paddle waits for a decision at most (ticks)
+		REWIND = 250
+	};
+	//! a ball which got past a remote player's paddle, see watchMiss()
+	struct Miss {
+		//! the player, NULL for none
+		Player* player;
+		//! the player's peer
+		grapple_user id;
+		//! the step the ball got there at, and when (ticks)
+		unsigned int tick, time;
+		//! where the ball touched the paddle's front, and its speed
+		Vec3f position, speed;
+	} miss;
+
 	grapple_server server;
 	grapple_client loopback;
 };
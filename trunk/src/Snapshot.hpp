@@ -0,0 +1,68 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <string>
+#include "stuff.hpp"
+#include "Interface.hpp"
+
+//! what is drawn of a ball, see Ball::takeSnapshot()
+struct BallSnapshot {
+	//! the position before the last move() and the actual one
+	Vec3f previous, position;
+	//! radius of the ball
+	Scalar radius;
+	//! when the last shrink() or grow() started and how long it takes (ticks)
+	unsigned int spawnstart, spawnlength;
+	//! wether the ball grows (or shrinks)
+	bool growing;
+};
+
+//! what is drawn of a paddle, see Player::takeSnapshot()
+struct PaddleSnapshot {
+	//! the player's name, shown along with the score
+	std::string name;
+	//! wether the paddle is in the FRONT or in the BACK
+	Side side;
+	//! the position of the paddle's center
+	Vec3f position;
+	//! width, height and thickness (bending) of the paddle
+	Scalar width, height, thickness;
+};
+
+//! what is drawn of the multiball swarm, see Multiball::takeSnapshot()
+struct SwarmSnapshot {
+	//! position of every ball before the last move()
+	std::vector<double> fromx, fromy, fromz;
+	//! the actual position of every ball
+	std::vector<double> x, y, z;
+	//! radius times scaling of every ball
+	std::vector<double> size;
+};
+
+//! Everything needed to draw a frame
+/*! Filled by the simulation thread after its steps and handed to the render thread by a
+    SnapshotBuffer. The render thread only draws what's in here, it never touches the game's
+    objects themselves, which the simulation thread changes (or deletes) meanwhile.
+*/
+struct Snapshot {
+	//! constructor for the time before the first one is filled
+	inline Snapshot() : time(0), finished(false), connecting(false) {}
+
+	//! the simulation time the state belongs to (ticks)
+	unsigned int time;
+	//! wether the game is over, so the render thread stops too
+	bool finished;
+	//! wether we still try to connect, so there's no field to draw
+	bool connecting;
+	//! the balls
+	std::vector<BallSnapshot> ball;
+	//! the paddles
+	std::vector<PaddleSnapshot> paddle;
+	//! the multiball swarm
+	SwarmSnapshot swarm;
+	//! the HUD's scores, messages and so on
+	Interface::Hud hud;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#include "SnapshotBuffer.hpp"
+
+SnapshotBuffer::SnapshotBuffer()
+ : back(0), middle(1), front(2)
+{
+}
+
+void SnapshotBuffer::publish()
+{
+	// everything written to the Snapshot has to be visible before its index is
+	__sync_synchronize();
+	back = __sync_lock_test_and_set(&middle, back | FRESH) & ~FRESH;
+}
+
+const Snapshot& SnapshotBuffer::take()
+{
+	if (middle & FRESH)
+		front = __sync_lock_test_and_set(&middle, front) & ~FRESH;
+	return slot[front];
+}
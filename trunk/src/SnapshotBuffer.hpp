@@ -0,0 +1,48 @@
+#ifndef SNAPSHOTBUFFER_H
+#define SNAPSHOTBUFFER_H
+
+#include "Snapshot.hpp"
+
+//! Hands the latest Snapshot from the simulation thread to the render thread, without locking
+/*! A triple buffer: the simulation thread fills one Snapshot while the render thread draws
+    another one; the third is the latest one published. Publishing and taking just swap the
+    index of a Snapshot with an atomic exchange, so neither thread ever waits for the other.
+    A slow frame doesn't hold up the simulation, and the render thread always gets the newest
+    complete state - the ones it was too slow for are skipped.
+    Only one thread may publish, and only one may take.
+*/
+class SnapshotBuffer
+{
+public:
+	//! The constructor
+	SnapshotBuffer();
+
+	//! returns the Snapshot the simulation thread fills next
+	/*! it may still hold an older state, so the vectors don't have to grow again */
+	inline Snapshot& getBack() { return slot[back]; }
+
+	//! make the filled Snapshot the latest one, called by the simulation thread
+	void publish();
+
+	//! returns the latest Snapshot, called by the render thread
+	/*! It stays untouched until the next take(). If nothing was published meanwhile,
+	    it's the same as the last time.
+	*/
+	const Snapshot& take();
+private:
+	enum {
+		//! or'ed to middle if it wasn't taken yet
+		FRESH = 4
+	};
+
+	//! the three Snapshots
+	Snapshot slot[3];
+	//! index of the one being filled, only used by the simulation thread
+	int back;
+	//! index of the latest published one, with FRESH; swapped by both threads
+	volatile int middle;
+	//! index of the one being drawn, only used by the render thread
+	int front;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "TimerWheel.hpp"
+#include <algorithm>
+
+TimerWheel::TimerWheel(unsigned int now)
+ : freelist(-1), current(now), active(0)
+{
+	for (int i = 0; i < LEVELS * SLOTS; i++)
+		head[i] = -1;
+}
+
+int TimerWheel::add(unsigned int intervall, EventReceiver::Event event, EventReceiver* receiver)
+{
+	int index = freelist;
+	if (index == -1) {
+		Entry fresh;
+		fresh.generation = 0;
+		entry.push_back(fresh);
+		index = entry.size() - 1;
+	} else	freelist = entry[index].next;
+
+	Entry& e = entry[index];
+	e.receiver = receiver;
+	e.event = event;
+	// no shorter than a tick, and no longer than the wheels reach
+	e.intervall = std::min(std::max(intervall, 1u), (1u << (BITS * LEVELS)) - 1);
+	e.expires = current + e.intervall;
+	link(index);
+	active++;
+	return (e.generation << INDEXBITS) | index;
+}
+
+void TimerWheel::remove(int handle)
+{
+	int index = handle & ((1 << INDEXBITS) - 1);
+	if ((handle < 0)||(index >= entry.size())||(entry[index].generation != (handle >> INDEXBITS)))
+		return;
+
+	Entry& e = entry[index];
+	if (e.slot != -1) unlink(index);
+	// the handles given out for this entry are stale from now on
+	e.generation = (e.generation + 1) & ((1 << (31 - INDEXBITS)) - 1);
+	e.next = freelist;
+	freelist = index;
+	active--;
+}
+
+void TimerWheel::link(int index)
+{
+	Entry& e = entry[index];
+	unsigned int delta = e.expires - current;
+	int level = 0;
+	while ((level < LEVELS - 1)&&(delta >= (1u << (BITS * (level + 1)))))
+		level++;
+
+	e.slot = level * SLOTS + ((e.expires >> (BITS * level)) & (SLOTS - 1));
+	e.prev = -1;
+	e.next = head[e.slot];
+	if (e.next != -1) entry[e.next].prev = index;
+	head[e.slot] = index;
+}
+
+void TimerWheel::unlink(int index)
+{
+	Entry& e = entry[index];
+	if (e.prev == -1)
+		head[e.slot] = e.next;
+	else	entry[e.prev].next = e.next;
+	if (e.next != -1) entry[e.next].prev = e.prev;
+	e.slot = -1;
+}
+
+int TimerWheel::cascade(int level)
+{
+	int slot = (current >> (BITS * level)) & (SLOTS - 1);
+	int index = head[level * SLOTS + slot];
+	head[level * SLOTS + slot] = -1;
+	while (index != -1)
+	{
+		int next = entry[index].next;
+		link(index);
+		index = next;
+	}
+	return slot;
+}
+
+int TimerWheel::advance(unsigned int now)
+{
+	int fired = 0;
+	if (active == 0) {
+		// nothing to wait for, the wheels may just jump
+		current = now;
+		return 0;
+	}
+
+	while ((int)(now - current) > 0)
+	{
+		current++;
+		int slot = current & (SLOTS - 1);
+		// the first wheel turned around, so the next one moves on a slot (and so on)
+		for (int level = 1; (slot == 0)&&(level < LEVELS); level++)
+			slot = cascade(level);
+		slot = current & (SLOTS - 1);
+
+		while (head[slot] != -1)
+		{
+			int index = head[slot];
+			unlink(index);
+			int generation = entry[index].generation;
+			fired++;
+			entry[index].receiver->action(entry[index].event);
+
+			// unless it got removed meanwhile, the timer goes on (entry may have moved, so look it up again)
+			if (entry[index].generation == generation) {
+				entry[index].expires += entry[index].intervall;
+				link(index);
+			}
+		}
+	}
+	return fired;
+}
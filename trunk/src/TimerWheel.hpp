@@ -0,0 +1,95 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <vector>
+#include "stuff.hpp"
+
+//! The timers of a game, run by its loop
+/*! A hierarchical timing wheel: LEVELS wheels of SLOTS lists each. The first wheel holds the timers
+    due within the next SLOTS ms, one list per ms; every further wheel has slots SLOTS times as long.
+    When the first wheel has turned around once, the actual slot of the next one is spread over the
+    wheels below, and so on. Adding and removing a timer is O(1), and advancing costs a little per ms
+    plus the timers due.
+    The timers live in a vector which only grows if more of them run at once than ever before; a freed
+    entry is taken again by the next add(). A handle carries the entry's generation, so removing a timer
+    twice, or one which already made room for another, does nothing.
+    There are no threads involved: the events are processed by advance(), right in the game loop.
+*/
+class TimerWheel
+{
+public:
+	//! The constructor
+	/*!	\param now the actual time in ticks (ms)
+	*/
+	TimerWheel(unsigned int now);
+
+	//! add a timer which triggers its event every intervall, until it's removed
+	/*!	\param intervall the intervall in ticks (ms), from 1 to the 4 hours the wheels cover
+		\param event the event the timer should trigger
+		\param receiver pointer to the receiving object
+		\result a handle needed to remove the timer, never -1
+	*/
+	int add(unsigned int intervall, EventReceiver::Event event, EventReceiver* receiver);
+
+	//! remove a timer; may be called from an action(), even for the timer just being processed
+	/*!	\param handle the handle given by add(); stale ones are ignored
+	*/
+	void remove(int handle);
+
+	//! process the events of all timers due until now
+	/*!	\param now the actual time in ticks (ms)
+		\result how many events were processed
+	*/
+	int advance(unsigned int now);
+
+	//! returns how many timers are running
+	inline int size() { return active; }
+private:
+	enum {
+		//! every wheel has 2^BITS slots
+		BITS = 6,
+		SLOTS = 1 << BITS,
+		//! the wheels cover 2^(BITS*LEVELS) ms, which is more than 4 hours
+		LEVELS = 4,
+		//! bits of a handle telling the entry, the ones above tell its generation
+		INDEXBITS = 16
+	};
+
+	//! a timer, or a free entry waiting to be taken again
+	struct Entry {
+		EventReceiver* receiver;
+		EventReceiver::Event event;
+		unsigned int intervall;
+		//! when the event is due (ticks)
+		unsigned int expires;
+		//! counts up whenever the entry is freed
+		int generation;
+		//! the list the entry is in, -1 for none
+		int slot;
+		//! neighbours in the list (or the next free entry), -1 for none
+		int prev, next;
+	};
+
+	//! put an entry into the slot its expiry time belongs to
+	void link(int index);
+	//! take an entry out of its slot
+	void unlink(int index);
+	//! spread a slot of a wheel over the wheels below
+	/*!	\param level the wheel
+		\result the slot which was spread
+	*/
+	int cascade(int level);
+
+	//! all timers and free entries
+	std::vector<Entry> entry;
+	//! the first entry of every slot's list, wheel by wheel
+	int head[LEVELS * SLOTS];
+	//! the first free entry, -1 for none
+	int freelist;
+	//! the time the wheels have turned to (ticks)
+	unsigned int current;
+	//! how many timers are running
+	int active;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "WorldState.hpp"
+#include <algorithm>
+
+WorldState::WorldState()
+ : tick(0), paddles(0)
+{
+	for (int i = 0; i < FIELDS; i++)
+		value[i] = 0;
+}
+
+void WorldState::setBall(const Vec3f& position)
+{
+	value[0] = Buffer::quantize(toDouble(position.x));
+	value[1] = Buffer::quantize(toDouble(position.y));
+	value[2] = Buffer::quantize(toDouble(position.z));
+}
+
+void WorldState::addPaddle(grapple_user player, const Vec2f& position)
+{
+	if (paddles == PADDLES) return;
+	id[paddles] = player;
+	value[3 + 2 * paddles] = Buffer::quantize(toDouble(position.x));
+	value[4 + 2 * paddles] = Buffer::quantize(toDouble(position.y));
+	paddles++;
+}
+
+Vec3f WorldState::getBall() const
+{
+	return Vec3f(Buffer::dequantize(value[0]), Buffer::dequantize(value[1]), Buffer::dequantize(value[2]));
+}
+
+Vec2f WorldState::getPaddle(int i) const
+{
+	return Vec2f(Buffer::dequantize(value[3 + 2 * i]), Buffer::dequantize(value[4 + 2 * i]));
+}
+
+bool WorldState::sameLayout(const WorldState& other) const
+{
+	if (paddles != other.paddles) return false;
+	for (int i = 0; i < paddles; i++)
+		if (id[i] != other.id[i]) return false;
+	return true;
+}
+
+void WorldState::write(Buffer& buf, const WorldState& base) const
+{
+	buf.pushVarint(tick);
+	// how far back the base lies, 0 for a keyframe
+	buf.pushVarint(base.tick == 0 ? 0 : tick - base.tick);
+	if (base.tick == 0) {
+		buf.pushVarint(paddles);
+		for (int i = 0; i < paddles; i++)
+			buf.pushId(id[i]);
+	}
+
+	// a bit for every value which changed, then by how much
+	unsigned int changed = 0;
+	for (int i = 0; i < fields(); i++)
+		if (value[i] != base.value[i]) changed |= 1 << i;
+	buf.pushVarint(changed);
+	for (int i = 0; i < fields(); i++)
+		if (changed & (1 << i)) buf.pushInt(value[i] - base.value[i]);
+}
+
+void WorldHistory::store(const WorldState& shot)
+{
+	state[shot.tick % SIZE] = shot;
+}
+
+const WorldState* WorldHistory::find(unsigned int tick) const
+{
+	const WorldState& kept = state[tick % SIZE];
+	return (tick != 0 && kept.tick == tick ? &kept : NULL);
+}
+
+bool WorldHistory::read(Buffer& buf, WorldState& shot) const
+{
+	unsigned int tick = buf.popVarint();
+	unsigned int distance = buf.popVarint();
+	if (distance == 0) {
+		shot = WorldState();
+		shot.paddles = std::min((int)buf.popVarint(), (int)WorldState::PADDLES);
+		for (int i = 0; i < shot.paddles; i++)
+			shot.id[i] = buf.popId();
+	} else {
+		const WorldState* base = find(tick - distance);
+		if (base == NULL) return false;
+		shot = *base;
+	}
+	shot.tick = tick;
+
+	unsigned int changed = buf.popVarint();
+	for (int i = 0; i < shot.fields(); i++)
+		if (changed & (1 << i)) shot.value[i] += buf.popInt();
+	return true;
+}
@@ -0,0 +1,89 @@
+#ifndef WORLDSTATE_H
+#define WORLDSTATE_H
+
+#include "Buffer.hpp"
+
+//! The state of the world the Server sends its Clients once per step, quantized
+/*! It's sent as a delta against a state the Client acknowledged, so mostly just the few values
+    which changed since, and only by how much. If there is no such state - the game just started,
+    or the Client's acknowledgements got lost for longer than the WorldHistory reaches back - a
+    keyframe goes out instead, which is a delta against nothing and needs nothing to be decoded.
+*/
+struct WorldState {
+	enum {
+		//! the most paddles a state holds
+		PADDLES = 4,
+		//! the most values a state holds: the ball's x, y and z, then x and y of every paddle
+		FIELDS = 3 + 2 * PADDLES
+	};
+
+	//! constructor for an empty state, the base of a keyframe
+	WorldState();
+
+	//! the number of the step the state was taken at, 0 for none
+	unsigned int tick;
+	//! how many paddles there are
+	int paddles;
+	//! the player every paddle belongs to
+	grapple_user id[PADDLES];
+	//! the values, quantized like Buffer::pushFixed()
+	short value[FIELDS];
+
+	//! returns how many values are in use
+	inline int fields() const { return 3 + 2 * paddles; }
+
+	//! note the ball's position
+	void setBall(const Vec3f& position);
+	//! add a paddle, if there's room
+	/*!	\param player the player it belongs to
+		\param position where its center is
+	*/
+	void addPaddle(grapple_user player, const Vec2f& position);
+	//! returns the ball's position
+	Vec3f getBall() const;
+	//! returns a paddle's position
+	/*!	\param i the paddle's index
+	*/
+	Vec2f getPaddle(int i) const;
+
+	//! wether both states hold the same paddles, so one can be a delta against the other
+	bool sameLayout(const WorldState& other) const;
+
+	//! write the state into a packet
+	/*!	\param buf the packet, a WORLD one
+		\param base what the receiver has already, an empty WorldState for a keyframe
+	*/
+	void write(Buffer& buf, const WorldState& base) const;
+};
+
+//! The latest WorldStates, by their tick
+/*! The Server keeps the ones it sent, the Client the ones it received, so both sides find the base
+    of a delta. Only SIZE states are kept, so deltas reach back SIZE steps at most: half a second,
+    which covers the round trip of any link worth playing on.
+*/
+class WorldHistory
+{
+public:
+	enum {
+		//! how many states are kept
+		SIZE = 64
+	};
+
+	//! keep a state, replacing the one SIZE ticks before
+	void store(const WorldState& state);
+
+	//! returns the state of a tick, NULL if it's not kept (anymore)
+	const WorldState* find(unsigned int tick) const;
+
+	//! read a state from a packet, decoding it against the one kept for its base
+	/*!	\param buf the WORLD packet
+		\param state filled with the state
+		\result false if the base isn't kept, so it can't be decoded
+	*/
+	bool read(Buffer& buf, WorldState& state) const;
+private:
+	//! the states, at their tick modulo SIZE
+	WorldState state[SIZE];
+};
+
+#endif
@@ -0,0 +1,737 @@
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <new>
+#include <sys/time.h>
+#include <unistd.h>
+#include "Framework.hpp"
+#include "Scheduler.hpp"
+#include "Match.hpp"
+#include "WorldState.hpp"
+
+//! heap allocations done so far, counted by our operator new (and malloc, where we can)
+static unsigned long allocations = 0;
+
+#ifdef __GLIBC__
+/* C code uses malloc() and realloc() directly, so with glibc we count these instead of new,
+   which ends up in malloc() anyway */
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_realloc(void* p, std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+
+void* malloc(std::size_t size) throw()
+{
+	__sync_fetch_and_add(&allocations, 1);
+	return __libc_malloc(size);
+}
+
+void* realloc(void* p, std::size_t size) throw()
+{
+	__sync_fetch_and_add(&allocations, 1);
+	return __libc_realloc(p, size);
+}
+
+void* calloc(std::size_t count, std::size_t size) throw()
+{
+	__sync_fetch_and_add(&allocations, 1);
+	return __libc_calloc(count, size);
+}
+}
+#endif
+
+void* operator new(std::size_t size)
+{
+#ifndef __GLIBC__
+	// the Scheduler benchmark allocates from several threads
+	__sync_fetch_and_add(&allocations, 1);
+#endif
+	void* p = malloc(size ? size : 1);
+	if (p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	free(p);
+}
+
+//! a Framework without video output and networking, it only hosts the simulation to be measured
+class World : public Framework
+{
+public:
+	//! set up an empty field
+	/*!	\param conf a Configuration asking for headless operation
+	*/
+	World(const Configuration& conf)
+	 : Framework(NULL, conf, UNINITIALIZED), scores(0) {}
+
+	//! two paddles covering the whole field, so every ball getting out went through one
+	void addWalls()
+	{
+		player.push_back(new Player(this, "front", FRONT, field.getLength()/2.0f));
+		player.push_back(new Player(this, "back", BACK, field.getLength()/2.0f));
+		player[0]->setSize(field.getWidth(), field.getHeight());
+		player[1]->setSize(field.getWidth(), field.getHeight());
+	}
+
+	//! put a single ball into the middle of the field
+	void serve(const Vec3f& speed)
+	{
+		ball.clear();
+		ball.push_back(Ball(this));
+		ball[0].setPosition(Vec3f(0.0, 0.0, 0.0));
+		ball[0].setSpeed(speed);
+	}
+
+	//! put count balls spread over the field into the game, like Multiball::spawn() does
+	void spawn(int count, double speed)
+	{
+		ball.clear();
+		for (int i = 0; i < count; i++)
+		{
+			ball.push_back(Ball(this));
+			ball[i].setPosition(Vec3f((rand() / (double)RAND_MAX - 0.5) * (field.getWidth() - 0.2),
+				(rand() / (double)RAND_MAX - 0.5) * (field.getHeight() - 0.2),
+				(rand() / (double)RAND_MAX - 0.5) * field.getLength() / 3.0));
+			ball[i].setSpeed(Vec3f((rand() / (double)RAND_MAX - 0.5) * speed,
+				(rand() / (double)RAND_MAX - 0.5) * speed,
+				(rand() % 2 ? speed : -speed)));
+		}
+	}
+
+	//! add a swarm of balls, like 'pong2 -m' does
+	void addSwarm(int count, double speed) { multiball.spawn(count, field, speed); }
+
+	inline Ball& getBall() { return ball[0]; }
+	inline std::vector<Ball>& getBalls() { return ball; }
+	inline Field& getField() { return field; }
+
+	//! how often a ball got out
+	int scores;
+private:
+	void movePaddle(double x, double y, unsigned int time) {}
+	void updateGame(int ticks)
+	{
+		if (!ball.empty()) ball[0].move(ticks);
+		multiball.move(ticks, field, player);
+	}
+	void doScore(Side side) { scores++; ball[0].setPosition(Vec3f(0.0, 0.0, 0.0)); }
+	void serveBall() {}
+	void ping() {}
+	void doNetworking() {}
+	void sendPacket(Buffer& data, bool reliable) {}
+};
+
+/* the ball movement as it was before the swept collision detection: the ball tests
+   positions 0.05 units apart for being stuck inside a wall or paddle */
+namespace legacy {
+
+//! the vector it used, always of doubles
+struct Vec3f {
+	Vec3f() : x(0.0), y(0.0), z(0.0) {}
+	Vec3f(double xn, double yn, double zn) : x(xn), y(yn), z(zn) {}
+	double x, y, z;
+};
+
+struct Collision {
+	Vec3f position;
+	Vec3f speed;
+};
+
+struct Paddle {
+	Vec3f position;
+	double width, height, thickness;
+};
+
+Collision* detectField(Field& field, const Vec3f& position, const Vec3f& speed, double radius)
+{
+	Collision *col = NULL;
+	if (fabs(position.z) - radius > fabs(field.getLength()/2.0))
+		return col;
+	double sign = (speed.x < 0 ? -1.0 : 1.0);
+	if (fabs(position.x) + radius >= field.getWidth()/2.0)
+	{
+		col = new Collision;
+		col->position.y = position.y;
+		col->position.z = position.z;
+		col->speed.y = speed.y;
+		col->speed.z = speed.z;
+		col->position.x = (field.getWidth()/2.0 - radius) * sign;
+		col->speed.x = -speed.x;
+	}
+	sign = (speed.y < 0 ? -1.0 : 1.0);
+	if (fabs(position.y) + radius >= field.getHeight()/2.0)
+	{
+		if (col == NULL) {
+			col = new Collision;
+			col->position.x = position.x;
+			col->position.z = position.z;
+			col->speed.x = speed.x;
+			col->speed.z = speed.z;
+		}
+		col->position.y = (field.getHeight()/2.0 - radius) * sign;
+		col->speed.y = -speed.y;
+	}
+	return col;
+}
+
+Collision* detectPaddle(const Paddle& p, const Vec3f& bposition, const Vec3f& bspeed, double radius)
+{
+	bool back = (p.position.z < 0);
+	if (back == (bposition.z > 0)) return NULL;
+	double zSign = (back ? -1.0 : 1.0);
+	if ((bposition.z*zSign + radius < p.position.z*zSign - p.thickness*5.0)
+	  ||(bposition.z*zSign > p.position.z*zSign))
+	return NULL;
+	int qx = (int)floor(fabs(bposition.x - p.position.x) / (p.width / 5.0f));
+	int qy = (int)floor(fabs(bposition.y - p.position.y) / (p.height / 5.0f));
+	if ((qx > 3)||(qy > 3)) return NULL;
+	if ((qx == 3)&&(fabs(bposition.x-radius - p.position.x) > p.width/2.0)) return NULL;
+	if ((qx == 3)&&(fabs(bposition.y-radius - p.position.y) > p.height/2.0)) return NULL;
+	if (back == (bspeed.z > 0)) return NULL;
+	double absz = p.position.z*zSign - p.thickness*(5.0 - (qx + qy));
+	if (bposition.z*zSign + radius < absz)
+		return NULL;
+	Collision* col = new Collision;
+	col->position = bposition;
+	col->speed.x = bspeed.x + qx * 0.2 * (bposition.x >= p.position.x ? 1.0 : -1.0);
+	col->speed.y = bspeed.y + qy * 0.2 * (bposition.y >= p.position.y ? 1.0 : -1.0);
+	col->speed.z = -bspeed.z;
+	return col;
+}
+
+//! the former Ball::move(), returns how many collision queries it did
+int move(Field& field, Paddle* paddle, Vec3f& position, Vec3f& speed, double radius, int ticks, int& scores)
+{
+	int queries = 0;
+	Vec3f destination;
+	double time = 1000.0 * 0.05f / std::max(fabs(speed.x), std::max(fabs(speed.y), fabs(speed.z)));
+	if (ticks < time) time = ticks;
+	// the original divided by zero here once the ball got faster than 100 units/s
+	for (int steps = 0; steps < ticks / std::max(1, (int)round(time)); steps++)
+	{
+		destination.x = position.x + speed.x * time / 1000.0;
+		destination.y = position.y + speed.y * time / 1000.0;
+		destination.z = position.z + speed.z * time / 1000.0;
+
+		queries++;
+		Collision* collide = detectField(field, destination, speed, radius);
+		for (int i = 0; (i < 2) && (collide == NULL); i++)
+			collide = detectPaddle(paddle[i], destination, speed, radius);
+
+		if (collide == NULL) {
+			position = destination;
+			if (field.zOutside(position.z) != NONE) {
+				scores++;
+				position = Vec3f(0.0, 0.0, 0.0);
+			}
+		} else {
+			position = collide->position;
+			speed = collide->speed;
+			delete collide;
+		}
+	}
+	return queries;
+}
+
+}
+
+//! wall clock in microseconds
+static double now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+//! print how long one operation took and how often it allocated
+/*!	\param name what was measured
+	\param start wall clock time the ops started (us)
+	\param allocated the allocation count when they started
+	\param ops how many were done
+*/
+static void report(const char* name, double start, unsigned long allocated, int ops)
+{
+	double elapsed = now() - start;
+	std::cout << "  " << name << "\t" << elapsed * 1000.0 / ops << "\t" << (double)(allocations - allocated) / ops << std::endl;
+}
+
+//! the hot paths of a game step, each on its own, in ns/op and allocs/op
+static void benchHotPaths(World& world)
+{
+	const int ops = 1000000;
+	const int samples = 1024;
+	Field& field = world.getField();
+
+	std::cout << "Hot paths, " << ops << " ops each" << std::endl;
+	std::cout << "  op\t\t\t\tns/op\tallocs/op" << std::endl;
+
+	// Ball::move() for a step of 8 ms, along and off the walls
+	double zspeed[] = { 6.0, 25.0, 100.0 };
+	const char* name[] = { "Ball::move speed 6\t", "Ball::move speed 25\t", "Ball::move speed 100\t" };
+	for (int s = 0; s < 3; s++)
+	{
+		world.serve(Vec3f(zspeed[s] * 0.3, zspeed[s] * 0.2, zspeed[s]));
+		unsigned long allocated = allocations;
+		double start = now();
+		for (int i = 0; i < ops; i++)
+			world.getBall().move(8);
+		report(name[s], start, allocated, ops);
+	}
+
+	// balls all over the field, flying somewhere for a step
+	srand(42);
+	std::vector<Vec3f> position(samples), speed(samples);
+	for (int i = 0; i < samples; i++)
+	{
+		position[i] = Vec3f((rand() / (double)RAND_MAX - 0.5) * (field.getWidth() - 0.4),
+			(rand() / (double)RAND_MAX - 0.5) * (field.getHeight() - 0.4),
+			(rand() / (double)RAND_MAX - 0.5) * field.getLength());
+		speed[i] = Vec3f((rand() / (double)RAND_MAX - 0.5) * 50.0,
+			(rand() / (double)RAND_MAX - 0.5) * 50.0,
+			(rand() / (double)RAND_MAX - 0.5) * 50.0);
+	}
+
+	Collision col;
+	int hits = 0;
+	unsigned long allocated = allocations;
+	double start = now();
+	for (int i = 0; i < ops; i++)
+	{
+		Scalar time = 0.008;
+		hits += field.detectCol(position[i % samples], speed[i % samples], 0.2, time, col);
+	}
+	report("Field::detectCol\t", start, allocated, ops);
+
+	Player paddle(&world, "bench", FRONT, field.getLength()/2.0);
+	allocated = allocations;
+	start = now();
+	for (int i = 0; i < ops; i++)
+	{
+		Scalar time = 0.1;
+		hits += paddle.detectCol(position[i % samples], speed[i % samples], 0.2, time, col);
+	}
+	report("Player::detectCol\t", start, allocated, ops);
+
+	// to and fro, running into the walls now and then
+	allocated = allocations;
+	start = now();
+	for (int i = 0; i < ops; i++)
+		paddle.move((i & 64 ? 0.3 : -0.3), (i & 128 ? 0.2 : -0.2), i + 1);
+	report("Player::move\t\t", start, allocated, ops);
+
+	Scalar reach = 0.0;
+	allocated = allocations;
+	start = now();
+	for (int i = 0; i < ops; i++)
+		reach += world.detectBarrier(position[i % samples].x, i & 3, FRONT);
+	report("Framework::detectBarrier", start, allocated, ops);
+
+	// the world, like the Server sends every step and the Client reads: a flying ball, two paddles,
+	// as a delta against the state of the step before
+	double sum = 0.0;
+	WorldHistory sent, received;
+	const WorldState keyframe;
+	unsigned int deltabytes = 0, keybytes = 0;
+	allocated = allocations;
+	start = now();
+	for (int i = 0; i < ops; i++)
+	{
+		WorldState world;
+		world.tick = i + 1;
+		world.setBall(Vec3f(((i & 511) - 256) / 128.0, 0.5 - (i & 255) / 256.0, ((i & 1023) - 512) / 128.0));
+		world.addPaddle(1, Vec2f(0.5, -0.5));
+		world.addPaddle(2, Vec2f(((i & 127) - 64) / 64.0, 0.25));
+		sent.store(world);
+
+		const WorldState* base = sent.find(i);
+		Buffer sbuf(WORLD);
+		world.write(sbuf, base != NULL ? *base : keyframe);
+		deltabytes += sbuf.getSize();
+
+		Buffer rbuf(sbuf.getData(), sbuf.getSize());
+		WorldState got;
+		if (received.read(rbuf, got)) {
+			received.store(got);
+			sum += got.value[0] + got.value[6];
+		}
+	}
+	report("WorldState delta write/read", start, allocated, ops);
+	{
+		WorldState world = *sent.find(ops);
+		Buffer sbuf(WORLD);
+		world.write(sbuf, keyframe);
+		keybytes = sbuf.getSize();
+	}
+
+	// a paddle movement, like a Client sends once per step
+	allocated = allocations;
+	start = now();
+	for (int i = 0; i < ops; i++)
+	{
+		Buffer sbuf(PADDLEMOVE);
+		sbuf.pushVarint(i); sbuf.pushVarint(i); sbuf.pushInt(i); sbuf.pushFixed(1.0); sbuf.pushFixed(2.0);
+		sum += sbuf.getSize() + sbuf.getData()[1];
+	}
+	report("Buffer build PADDLEMOVE", start, allocated, ops);
+
+	// what goes over the wire per step, before grapple's header
+	Buffer paddlemove(PADDLEMOVE);
+	paddlemove.pushVarint(1000); paddlemove.pushVarint(10000); paddlemove.pushInt(100000); paddlemove.pushFixed(0.5); paddlemove.pushFixed(-0.5);
+	std::cout << "  payload bytes: WORLD delta " << (double)deltabytes / ops << ", keyframe " << keybytes
+		<< " (raw doubles: " << sizeof(PacketType) + 3 * sizeof(double) + 2 * (sizeof(grapple_user) + 2 * sizeof(double))
+		<< "), PADDLEMOVE " << paddlemove.getSize() << " (raw: " << sizeof(PacketType) + 3 * sizeof(int) + 2 * sizeof(double)
+		<< ")" << std::endl;
+
+	// keep the results alive, or the compiler could drop the work
+	if (hits + toDouble(reach) + sum == 0.5) std::cout << std::endl;
+}
+
+//! Ball::move() against the former sub-stepping at several ball speeds
+static void benchBallMove(World& world)
+{
+	const int frames = 200000;
+	const int ticks = 7;
+	double zspeed[] = { 6.0, 12.0, 25.0, 50.0, 100.0, 200.0 };
+
+	// simulated seconds
+	const double seconds = frames * ticks / 1000.0;
+
+	std::cout << "Ball::move, " << frames << " frames of " << ticks << " ms" << std::endl;
+	std::cout << "  speed\tstepped ns/frame\tqueries/frame\tallocs/s\ttunneled"
+		"\tswept ns/frame\tallocs/s\ttunneled" << std::endl;
+
+	for (int s = 0; s < 6; s++)
+	{
+		Vec3f speed(zspeed[s] * 0.3, zspeed[s] * 0.2, zspeed[s]);
+
+		legacy::Paddle paddle[2] = {
+			{ legacy::Vec3f(0.0, 0.0,  world.getField().getLength()/2.0), world.getField().getWidth(), world.getField().getHeight(), 0.05 },
+			{ legacy::Vec3f(0.0, 0.0, -world.getField().getLength()/2.0), world.getField().getWidth(), world.getField().getHeight(), 0.05 }
+		};
+		legacy::Vec3f lpos(0.0, 0.0, 0.0), lspeed(zspeed[s] * 0.3, zspeed[s] * 0.2, zspeed[s]);
+		int lscores = 0, queries = 0;
+		unsigned long allocated = allocations;
+		double start = now();
+		for (int i = 0; i < frames; i++)
+			queries += legacy::move(world.getField(), paddle, lpos, lspeed, 0.2, ticks, lscores);
+		double stepped = (now() - start) * 1000.0 / frames;
+		double lallocs = (allocations - allocated) / seconds;
+
+		world.serve(speed);
+		world.scores = 0;
+		allocated = allocations;
+		start = now();
+		for (int i = 0; i < frames; i++)
+			world.getBall().move(ticks);
+		double swept = (now() - start) * 1000.0 / frames;
+		double sallocs = (allocations - allocated) / seconds;
+
+		std::cout << "  " << zspeed[s] << "\t" << stepped << "\t\t\t" << (double)queries / frames
+			<< "\t\t" << lallocs << "\t\t" << lscores
+			<< "\t\t" << swept << "\t\t" << sallocs << "\t\t" << world.scores << std::endl;
+	}
+}
+
+//! Multiball::fly() against moving as many Ball objects, and Multiball::collide() on its own, in balls * steps per second
+static void benchMultiball(World& world)
+{
+	const int ticks = 7;
+	const double speed = 6.0;
+	int count[] = { 16, 256, 4096 };
+
+	std::cout << "Multiball::move (" << Multiball::simd() << "), frames of " << ticks << " ms" << std::endl;
+	std::cout << "  balls\tBall::move balls*steps/s\tMultiball::fly balls*steps/s\tspeedup\tball-ball collisions balls*steps/s" << std::endl;
+
+	for (int c = 0; c < 3; c++)
+	{
+		// the same amount of work for every swarm size
+		int frames = 2000000 / count[c];
+
+		srand(42);
+		world.spawn(count[c], speed);
+		std::vector<Ball>& balls = world.getBalls();
+		double start = now();
+		for (int i = 0; i < frames; i++)
+			for (int b = 0; b < balls.size(); b++)
+				balls[b].move(ticks);
+		double scalar = (double)frames * count[c] / ((now() - start) / 1000000.0);
+
+		srand(42);
+		Multiball swarm;
+		swarm.spawn(count[c], world.getField(), speed);
+		start = now();
+		for (int i = 0; i < frames; i++)
+			swarm.fly(ticks, world.getField(), world.getPlayers());
+		double flown = now() - start;
+		double vector = (double)frames * count[c] / (flown / 1000000.0);
+
+		// the same swarm once more with the collisions, which take whatever it needs on top
+		srand(42);
+		Multiball bouncing;
+		bouncing.spawn(count[c], world.getField(), speed);
+		start = now();
+		for (int i = 0; i < frames; i++)
+			bouncing.move(ticks, world.getField(), world.getPlayers());
+		double collided = (double)frames * count[c] / (std::max(1.0, now() - start - flown) / 1000000.0);
+
+		std::cout << "  " << count[c] << "\t" << scalar << "\t\t\t" << vector << "\t\t\t" << vector / scalar
+			<< "\t" << collided << std::endl;
+	}
+}
+
+//! looks for touching balls by testing every pair
+/*! \result how many pairs touch
+*/
+static int touchingPairs(Multiball& swarm)
+{
+	int touching = 0;
+	for (int i = 0; i < swarm.size(); i++)
+		for (int j = i + 1; j < swarm.size(); j++)
+		{
+			Vec3f a = swarm.getPosition(i), b = swarm.getPosition(j);
+			double reach = swarm.getRadius(i) + swarm.getRadius(j);
+			if ((a.x-b.x)*(a.x-b.x) + (a.y-b.y)*(a.y-b.y) + (a.z-b.z)*(a.z-b.z) < reach*reach)
+				touching++;
+		}
+	return touching;
+}
+
+//! Multiball::move() including the ball-ball collisions for growing swarms, against testing every pair
+static void benchGrid(World& world)
+{
+	const int ticks = 7;
+	const double speed = 6.0;
+	int count[] = { 64, 256, 1024, 4096, 16384 };
+
+	std::cout << "Multiball::move with grid broadphase, frames of " << ticks << " ms" << std::endl;
+	std::cout << "  balls\tgrid ns/ball\tpair tests/ball\tevery pair ns/ball\tpair tests/ball\ttouching" << std::endl;
+
+	for (int c = 0; c < 5; c++)
+	{
+		int frames = 2000000 / count[c];
+
+		srand(42);
+		Multiball swarm;
+		swarm.spawn(count[c], world.getField(), speed);
+		unsigned long pairs = swarm.getPairTests();
+		double start = now();
+		for (int i = 0; i < frames; i++)
+			swarm.move(ticks, world.getField(), world.getPlayers());
+		double grid = (now() - start) * 1000.0 / frames / count[c];
+		double tests = (double)(swarm.getPairTests() - pairs) / frames / count[c];
+
+		// every pair only needs to be found, so a few frames tell enough
+		int brute = std::max(1, 20000 / count[c]);
+		int touching = 0;
+		start = now();
+		for (int i = 0; i < brute; i++)
+			touching += touchingPairs(swarm);
+		double every = (now() - start) * 1000.0 / brute / count[c];
+
+		std::cout << "  " << count[c] << "\t" << grid << "\t\t" << tests
+			<< "\t\t" << every << "\t\t\t" << (count[c] - 1) / 2.0 << "\t\t" << touching / brute << std::endl;
+	}
+}
+
+//! adds the values of v to an FNV-1a hash, lowest byte first whatever the machine's byte order
+static unsigned int hash(unsigned int h, const Vec3f& v)
+{
+	Scalar value[3] = { v.x, v.y, v.z };
+	for (int i = 0; i < 3; i++)
+	{
+		uint64_t bits = toBits(value[i]);
+		for (int b = 0; b < 64; b += 8)
+			h = (h ^ (unsigned int)((bits >> b) & 0xff)) * 16777619u;
+	}
+	return h;
+}
+
+//! a long replay of fixed steps, hashing the ball after each one
+/*! Built with and without -DFIXED_POINT on two machines, the fixed point hashes have to match,
+    the double ones may not.
+*/
+static void benchReplay(World& world)
+{
+	const int steps = 1000000;
+	double zspeed[] = { 6.0, 25.0, 100.0 };
+
+#ifdef FIXED_POINT
+	std::cout << "Replay with fixed point (" << Fixed::BITS << " bits behind the point), ";
+#else
+	std::cout << "Replay with double, ";
+#endif
+	std::cout << steps << " steps of 8 ms" << std::endl;
+	std::cout << "  speed	ns/step		hash" << std::endl;
+
+	for (int s = 0; s < 3; s++)
+	{
+		world.serve(Vec3f(zspeed[s] * 0.3, zspeed[s] * 0.2, zspeed[s]));
+		unsigned int h = 2166136261u;
+		double start = now();
+		for (int i = 0; i < steps; i++)
+		{
+			world.getBall().move(8);
+			h = hash(hash(h, world.getBall().getPosition()), world.getBall().getSpeed());
+		}
+		double step = (now() - start) * 1000.0 / steps;
+
+		std::cout << "  " << zspeed[s] << "	" << step << "		" << std::hex << h << std::dec << std::endl;
+	}
+}
+
+//! counts the timer events it gets
+struct Counter : public EventReceiver {
+	Counter() : count(0) {}
+	void action(Event event) { count++; }
+	unsigned long count;
+};
+
+//! does nothing, given to the SDL timers which must not fire while measured
+static unsigned int idle(unsigned int intervall, void* data)
+{
+	return intervall;
+}
+
+//! the TimerWheel against SDL timers
+static void benchTimers()
+{
+	const int ops = 200000;
+	const int background = 1000;
+	Counter counter;
+
+	std::cout << "Timers, " << background << " running meanwhile" << std::endl;
+	std::cout << "  op\t\t\t\tns/op\tallocs/op" << std::endl;
+
+	// adding and removing, like the Server does for every ball going out
+	TimerWheel wheel(0);
+	for (int i = 0; i < background; i++)
+		wheel.add(10000 + i, EventReceiver::ACCELERATE, &counter);
+	unsigned long allocated = allocations;
+	double start = now();
+	for (int i = 0; i < ops; i++)
+		wheel.remove(wheel.add(25, EventReceiver::BALLOUT, &counter));
+	report("TimerWheel add/remove\t", start, allocated, ops);
+
+	std::vector<SDL_TimerID> sdl;
+	for (int i = 0; i < background; i++)
+		sdl.push_back(SDL_AddTimer(10000 + i, idle, NULL));
+	allocated = allocations;
+	start = now();
+	for (int i = 0; i < ops; i++)
+		SDL_RemoveTimer(SDL_AddTimer(25, idle, NULL));
+	report("SDL_AddTimer/RemoveTimer", start, allocated, ops);
+	for (int i = 0; i < background; i++)
+		SDL_RemoveTimer(sdl[i]);
+
+	// a second of a busy game: every 25 ms, every timer triggers its event
+	TimerWheel busy(0);
+	for (int i = 0; i < background; i++)
+		busy.add(25, EventReceiver::ACCELERATE, &counter);
+	int events = 0;
+	allocated = allocations;
+	start = now();
+	for (unsigned int t = 1; t <= 1000; t++)
+		events += busy.advance(t);
+	report("TimerWheel per event\t", start, allocated, events);
+}
+
+//! Mr. Wand against himself, like 'pong2 -r'
+static void benchRallies()
+{
+	const unsigned long rallies = 200000;
+	Configuration conf;
+	conf.dedicated = true;
+
+	std::cout << "Match, Mr. Wand against himself missing by up to 1.0, " << rallies << " rallies" << std::endl;
+	Match match(conf, 1.0);
+	unsigned long allocated = allocations;
+	double start = now();
+	match.play(rallies);
+	double elapsed = now() - start;
+	std::cout << "  ns/step " << elapsed * 1000.0 / match.getSteps()
+		<< ", allocs/step " << (double)(allocations - allocated) / match.getSteps() << std::endl;
+	match.report((unsigned int)(elapsed / 1000.0));
+}
+
+//! how many games the Scheduler runs per core at 125 Hz, for several thread counts
+static void benchScheduler()
+{
+	const int games = 512;
+	const int rounds = 500;
+	int swarm[] = { 0, 64 };
+	int cores = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+	int threads[] = { 1, 2, 4, cores };
+
+	std::cout << "Scheduler, " << games << " games of a single ball, " << rounds << " rounds" << std::endl;
+	std::cout << "  swarm\tthreads\tticks/s\t\tgames per core\tp50 us\tp99 us\tmax us" << std::endl;
+
+	for (int s = 0; s < 2; s++)
+		for (int t = 0; t < 4; t++)
+		{
+			if ((threads[t] > cores)||((t == 3)&&(cores <= 4))) continue;
+
+			Configuration conf;
+			conf.dedicated = true;
+			Scheduler pool(threads[t]);
+			srand(42);
+			for (int i = 0; i < games; i++)
+			{
+				World* world = new World(conf);
+				world->addWalls();
+				world->serve(Vec3f(1.8, 1.2, 6.0));
+				world->addSwarm(swarm[s], 6.0);
+				pool.add(world);
+			}
+
+			// every round is exactly one step for every game, as fast as we can
+			unsigned int time = SDL_GetTicks();
+			pool.round(time);
+			pool.resetStats();
+			double start = now();
+			for (int i = 0; i < rounds; i++)
+				pool.round(time += 8);
+			double ticks = (double)games * rounds / ((now() - start) / 1000000.0);
+
+			unsigned int p50, p99, max;
+			int worst;
+			pool.getStats(p50, p99, max, worst);
+			std::cout << "  " << swarm[s] << "\t" << threads[t] << "\t" << ticks << "\t" << ticks / 125.0 / threads[t]
+				<< "\t\t" << p50 << "\t" << p99 << "\t" << max << std::endl;
+		}
+}
+
+//! runs the simulation benchmarks without any window or GL context
+int main(int argc, char **argv)
+{
+	// only for comparing with the SDL timers
+	SDL_Init(SDL_INIT_TIMER);
+
+	Configuration conf;
+	conf.dedicated = true;
+
+	World world(conf);
+	world.addWalls();
+
+	benchHotPaths(world);
+	benchBallMove(world);
+	benchReplay(world);
+	benchMultiball(world);
+	benchGrid(world);
+	benchRallies();
+	benchTimers();
+	benchScheduler();
+
+	return EXIT_SUCCESS;
+}
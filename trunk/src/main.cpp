@@ -6,19 +6,31 @@
 
 #include "Server.hpp"
 #include "Client.hpp"
+#include "Scheduler.hpp"
+#include "Match.hpp"
 
 //! usage declaration printed if the user gives in a malformed argument, like -h
 #define USAGE \
-"[-n <name>] [-c <server>] [-p <port>] [-w <width> -h <height>]\
-\n[-b <bitsperpixel>] [-f]\
+"[-n <name>] [-c <server> | -d] [-p <port>] [-w <width> -h <height>]\
+\n[-b <bitsperpixel>] [-f] [-s <fps> | -s vsync] [-m <balls>] [-g <games> [-j <threads>]]\
+\n[-r <rallies>] [-t <file>] [-u <rate>]\
 \n\
 \n -n \t set your name (default: Hans)\
 \n -c \t connect to already running server (default: act as server)\
+\n -d \t act as dedicated server without any video output\
 \n -p \t set alternative udp networking port (default: 6642)\
 \n -w \t set x resolution in pixels (default: 1024)\
 \n -h \t set y resolution in pixels (default: 768)\
 \n -b \t set individual bitsperpixel (default: 32)\
 \n -f \t operate in fullscreen mode (default: windowed, toggle with 'f' key)\
+\n -s \t draw this many frames per second, 0 for as many as possible, or vsync to\
+\n    \t draw once per refresh of the display (default: 125)\
+\n -m \t multiball: add this many balls to the game, as server (default: 0)\
+\n -g \t act as dedicated server hosting this many games, on the ports from -p on\
+\n -j \t run the hosted games on this many threads (default: one per processor)\
+\n -r \t let Mr. Wand play this many rallies against himself as fast as possible, then exit\
+\n -t \t write the time spent in every phase of the latest frames to this CSV file on exit\
+\n -u \t send the ball and paddles at most this many times per second, as server (default: 125)\
 \n -v \t show version information and exit\
 \n"
 
@@ -42,13 +54,16 @@ int main (int argc, char **argv)
 	Configuration conf;
 	std::cout << "Pong2 version " << VERSION << " (network protocol version " << conf.version << ")\n";
 	int c;
-	while ((c = getopt(argc, argv, "c:p:w:h:b:fn:v")) != EOF) {
+	while ((c = getopt(argc, argv, "c:dp:w:h:b:fs:n:m:g:j:r:t:u:v")) != EOF) {
 		std::stringstream hlp;
 		switch (c) {
 		case 'c':
 			conf.mode = Configuration::CLIENT;
 			conf.servername = optarg;
 			break;
+		case 'd':
+			conf.dedicated = true;
+			break;
 		case 'p':
 			hlp << optarg;
 			hlp >> conf.port;
@@ -68,9 +83,43 @@ int main (int argc, char **argv)
 		case 'f':
 			conf.fullscreen = true;
 			break;
+		case 's':
+			if (std::string(optarg) == "vsync")
+				conf.pacing = Configuration::VSYNC;
+			else {
+				hlp << optarg;
+				hlp >> conf.fps;
+				conf.pacing = (conf.fps > 0 ? Configuration::TARGET : Configuration::UNCAPPED);
+			}
+			break;
 		case 'n':
 			conf.playername = optarg;
 			break;
+		case 'm':
+			hlp << optarg;
+			hlp >> conf.multiball;
+			break;
+		case 'g':
+			hlp << optarg;
+			hlp >> conf.matches;
+			conf.dedicated = true;
+			break;
+		case 'j':
+			hlp << optarg;
+			hlp >> conf.threads;
+			break;
+		case 'r':
+			hlp << optarg;
+			hlp >> conf.rallies;
+			conf.dedicated = true;
+			break;
+		case 't':
+			conf.profile = optarg;
+			break;
+		case 'u':
+			hlp << optarg;
+			hlp >> conf.worldrate;
+			break;
 		case 'v':
 			exit(1);
 			break;
@@ -80,16 +129,62 @@ int main (int argc, char **argv)
 		}
 	}
 
+	if (conf.dedicated && (conf.mode != Configuration::SERVER))
+	{
+		std::cerr << "Usage: " << argv[0] << " " << USAGE;
+		exit(1);
+	}
+
 	/* register cleanup function */
 	atexit(Quit);
 
+	/* SDL only runs its event queue along with the video subsystem. As a dedicated server
+	   we still need events (quitting), so we take the dummy driver which doesn't
+	   need any display at all */
+	if (conf.dedicated)
+		SDL_putenv((char*)"SDL_VIDEODRIVER=dummy");
+
 	/* initialize SDL */
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0)
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 	{
 		std::cerr << "can't initialize SDL video: " << SDL_GetError() << std::endl;
 		exit(EXIT_FAILURE);
 	}
 
+	if (conf.rallies > 0)
+	{
+		/* no network, no waiting: the Mr. Wands miss by up to a paddle width, so the rallies end */
+		Match match(conf, 1.0);
+		unsigned int start = SDL_GetTicks();
+		match.play(conf.rallies);
+		match.report(SDL_GetTicks() - start);
+		return EXIT_SUCCESS;
+	}
+
+	if (conf.matches > 0)
+	{
+		/* every game gets its own port, all of them share the threads */
+		Scheduler pool(conf.threads);
+		for (int i = 0; i < conf.matches; i++)
+		{
+			Configuration game = conf;
+			game.port = conf.port + i;
+			pool.add(new Server(NULL, game));
+		}
+		std::cout << "hosting " << pool.size() << " games on ports " << conf.port << "-"
+			<< conf.port + conf.matches - 1 << ", " << pool.getThreads() << " threads" << std::endl;
+		pool.run();
+		return EXIT_SUCCESS;
+	}
+
+	if (conf.dedicated)
+	{
+		/* no surface, no OpenGL: the Server only simulates and talks to its clients */
+		Server server(NULL, conf);
+		server.loop();
+		return EXIT_SUCCESS;
+	}
+
 	/* SDL_SetVideoMode flags */
 	int videoFlags = SDL_OPENGL;
 
@@ -97,6 +192,13 @@ int main (int argc, char **argv)
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 	/* Sets up the stencil buffer */
 	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 1);
+#if SDL_VERSION_ATLEAST(1, 2, 10)
+	/* Lets SDL_GL_SwapBuffers() wait for the display only if asked to, see FramePacer */
+	SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, conf.pacing == Configuration::VSYNC);
+#else
+	if (conf.pacing == Configuration::VSYNC)
+		std::cerr << "this SDL can't wait for the display, drawing as many frames as possible" << std::endl;
+#endif
 
 	/* Get an SDL surface */
 	SDL_Surface *surface = SDL_SetVideoMode(conf.width, conf.height, conf.bpp, videoFlags);
@@ -106,7 +208,7 @@ int main (int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
-	SDL_WM_SetCaption("Pong", NULL);
+	SDL_WM_SetCaption("Pong�", NULL);
 
 	/* Initialize the networking - net2 is based on sdlnet */
 	/*if (SDLNet_Init() == -1)
@@ -122,9 +224,10 @@ int main (int argc, char **argv)
 	}*/
 
 	/* create the Server or Client object which controls the game */
-	if (conf.mode == Configuration::SERVER)
-		Server((void*)surface, conf);
-	else	Client((void*)surface, conf);
+	if (conf.mode == Configuration::SERVER) {
+		Server server((void*)surface, conf);
+		server.loop();
+	} else	Client((void*)surface, conf);
 
 	return EXIT_SUCCESS;
 }
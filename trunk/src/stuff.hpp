@@ -2,15 +2,34 @@
 #define STUFF_H
 #include <string>
 #include <sstream>
+#include <limits>
+#include <cstring>
+#include <stdint.h>
+
+/* the type positions, speeds and times of the simulation are made of:
+   doubles by default, with -DFIXED_POINT a Fixed for bit exact results */
+#ifdef FIXED_POINT
+#include "Fixed.hpp"
+typedef Fixed Scalar;
+#else
+typedef double Scalar;
+#endif
+
+//! returns a double as double, the counterpart to toDouble(Fixed)
+inline double toDouble(double a) { return a; }
+//! returns the whole part of a whole double, the counterpart to toInt(Fixed), so use floor() first
+inline int toInt(double a) { return (int)a; }
+//! returns the bits of a double, the counterpart to toBits(Fixed)
+inline uint64_t toBits(double a) { uint64_t b; memcpy(&b, &a, sizeof(b)); return b; }
 
 class Player;
 
 //! the game configuration, which can mostly be altered by command line settings
 struct Configuration {
 	//! the constructor preinitializing default values
-	inline Configuration() : version("10"),
-		width(1024), height(768), bpp(32), fullscreen(false),
-		playername("Hans"), mode(SERVER), servername(""), port(6642) {}
+	inline Configuration() : version("16"),
+		width(1024), height(768), bpp(32), fullscreen(false), dedicated(false), multiball(0), matches(0), threads(0), rallies(0),
+		pacing(TARGET), fps(125), profile(""), worldrate(125), playername("Hans"), mode(SERVER), servername(""), port(6642) {}
 	//! the game's network protocol version (libgrapple wants a string here)
 	std::string version;
 	//! the screen size in pixels
@@ -19,6 +38,31 @@ struct Configuration {
 	int bpp;
 	//! wether to start up in fullscreen mode or not
 	bool fullscreen;
+	//! wether to run as a dedicated server without any video output (no window, no OpenGL)
+	bool dedicated;
+	//! how many additional balls the server puts into the field (multiball mode)
+	int multiball;
+	//! how many games a dedicated server hosts at once, each on its own port; 0 for a single one
+	int matches;
+	//! how many threads run the hosted games; 0 for one per processor
+	int threads;
+	//! how many rallies Mr. Wand plays against himself, without window and network; 0 for a real game
+	unsigned long rallies;
+	//! how the frames are paced, see FramePacer
+	enum Pacing {
+		//! draw fps frames per second, sleeping in between
+		TARGET,
+		//! draw once per refresh of the display, waiting for it
+		VSYNC,
+		//! draw as many frames as possible, to benchmark
+		UNCAPPED
+	} pacing;
+	//! the frames per second to draw in TARGET mode
+	int fps;
+	//! the CSV file the latest frames' phase timings are written to on exit, empty for none (see FrameProfiler)
+	std::string profile;
+	//! how many WorldStates per second a server sends every client at most, one per step; fewer if its link is congested
+	int worldrate;
 	//! what role to play (used on startup)
 	enum Netmode {
 		//! be a game controlling server
@@ -54,26 +98,26 @@ enum Side {
 	BOTTOM
 };
 
-//! a two dimensional double (not float) vector
+//! a two dimensional Scalar (double, not float) vector
 struct Vec2f {
 	//! default constructor
 	inline Vec2f() {}
 	//! constructor giving the values
-	inline Vec2f(double xx, double xy)
+	inline Vec2f(Scalar xx, Scalar xy)
 	 : x(xx), y(xy) {}
 	//! the two values itself
-	double x, y;
+	Scalar x, y;
 };
 
-//! a three dimensional double (not float) vector
+//! a three dimensional Scalar (double, not float) vector
 struct Vec3f {
 	//! default constructor
 	inline Vec3f() {}
 	//! constructor giving the values
-	inline Vec3f(double xx, double xy, double xz)
+	inline Vec3f(Scalar xx, Scalar xy, Scalar xz)
 	 : x(xx), y(xy), z(xz) {}
 	//! the three values itself
-	double x, y, z;
+	Scalar x, y, z;
 };
 
 //! an occured collision of a ball against stuff
@@ -92,16 +136,8 @@ struct EventReceiver {
 	enum Event {
 		//! accelerate stuff! (used by Ball)
 		ACCELERATE,
-		//! decelerate stuff! (used by Player)
-		DECELERATE,
 		//! the ball got out of the field and needs to be reinserted
-		BALLOUT,
-		//! shrink the ball!
-		SHRINK,
-		//! grow the ball!
-		GROW,
-		//! decrease the alpha value of a flashing message
-		DEFLASH
+		BALLOUT
 	};
 
 	//! responsible for actions to be taken after the timer intervall is over